@@ -3,15 +3,21 @@
 
 #include "gomoku_ai_datav2.h"
 #include "gomoku_ai_interface.h"
+#include <chrono>
 
 namespace AI::MinMaxV2
 {
 
 struct GomokuAiSettings
 {
+    /** Search depth, or deepest iteration when the search is limited */
     int depth = 4;
     int length = 2;
     GomokuAIData data = GomokuAIData();
+    /** Time allowed to a search in milliseconds. 0 searches at the fixed depth */
+    int time_budget_ms = 0;
+    /** Maximum number of nodes of a search. 0 means no limit */
+    uint64_t node_limit = 0;
 };
 
 struct MoveEvaluation
@@ -51,15 +57,29 @@ public:
 
 private:
     GomokuGame game;
-    int depth;  // min max depth algorithm
-    int length; // evaluated moves distance from structures
+    int depth;        // min max depth algorithm
+    int search_depth; // depth of the current iteration
+    int length;       // evaluated moves distance from structures
     Player ai_player;
     Player human_player;
     GomokuAIData evaluation_data; // heuristic evaluation data
 
     std::vector<std::pair<int, int>> killer_moves;
 
-    void evaluateNode(const MoveHeuristic &move, int moveId, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremEval, std::pair<int, int> &best_move, bool isFirstMove);
+    /** Search limits */
+    int time_budget_ms;
+    uint64_t node_limit;
+    uint64_t searched_nodes;
+    bool search_can_abort;
+    bool search_aborted;
+    std::chrono::steady_clock::time_point search_deadline;
+
+    bool search_is_limited() const;
+    bool search_limit_reached();
+    void iterative_deepening(MoveEvaluation &result);
+
+    /** Return false when the move is illegal */
+    bool evaluateNode(const MoveHeuristic &move, int moveId, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremEval, std::pair<int, int> &best_move, bool isFirstMove);
 
     void minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bool maximizingPlayer, int row, int col);
     int score_player(Player player);
@@ -3,16 +3,60 @@
 
 #include "gomoku_ai_datav3.h"
 #include "gomoku_ai_interface.h"
+#include "gomoku_ai_transposition_table.h"
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <optional>
 
 namespace AI::MinMaxV3
 {
 
 struct GomokuAiSettings
 {
+    /** Search depth, or deepest iteration when the search is limited */
     int depth = 4;
     int length = 2;
     GomokuAIData data = GomokuAIData();
+    /** Entries of the transposition table, rounded down to a power of two. 0 disables it */
+    size_t transposition_table_size = 1 << 18;
+    /** Time allowed to a search in milliseconds. 0 searches at the fixed depth */
+    int time_budget_ms = 0;
+    /** Maximum number of nodes of a search. 0 means no limit */
+    uint64_t node_limit = 0;
+    /** Threads searching the move. Helper threads fill the shared transposition table, which must be enabled */
+    int threads = 1;
+    /** Order moves from the move gains of the game instead of playing and evaluating each of them */
+    bool gain_move_ordering = false;
+    /** Principal variation search: moves after the first one are searched with a null window,
+     * and searched again with the full window when they may be better */
+    bool principal_variation_search = false;
+    /** Half width of the window searched first at the root around the score of the previous iteration,
+     * when the search is iterated. 0 searches the full window */
+    int aspiration_window = 0;
+};
+
+struct SearchStatistics
+{
+    uint64_t nodes = 0;
+    uint64_t tt_hits = 0;
+    uint64_t tt_cutoffs = 0;
+    /** Moves searched again by the principal variation search */
+    uint64_t pvs_researches = 0;
+    /** Root searches done again after failing out of the aspiration window */
+    uint64_t aspiration_researches = 0;
+    int completed_depth = 0;
+    int threads = 1;
+    uint64_t helper_nodes = 0;
+    double elapsed_ms = 0;
+};
+
+/** Change of the structure scores of black and white made by a move */
+struct StructureScoreDelta
+{
+    int black = 0;
+    int white = 0;
 };
 
 struct MoveHeuristic
@@ -50,6 +94,7 @@ public:
 
     int get_heuristic_evaluation(const GomokuGame &board, Player player) override;
     const GomokuAIData &get_evaluation_data() const;
+    const SearchStatistics &get_search_statistics() const;
 
 private:
     GomokuGame game;
@@ -61,19 +106,63 @@ private:
     bool deepening;
     bool deepening_successful;
     int deepened_move_score;
+    int ply; // distance from the root of the search
+    bool gain_move_ordering;
+    bool principal_variation_search;
+    int aspiration_window;
 
     std::vector<std::pair<int, int>> killer_moves;
-
-    void evaluateNode(const MoveHeuristic &move, int move_id, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremEval, std::pair<int, int> &best_move, bool isFirstMove);
+    std::shared_ptr<TranspositionTable> transposition_table;
+    /** Board size of the positions in the table and of the killer moves, hash keys don't depend on it */
+    int transposition_width;
+    int transposition_height;
+    SearchStatistics statistics;
+
+    /** Lazy SMP: helpers search the same position in their own thread and
+     * share the transposition table of the main search */
+    std::vector<std::unique_ptr<GomokuAI>> helpers;
+    int helper_id; // 0 for the main search
+    const std::atomic<bool> *stop_signal;
+
+    void run_helper(const GomokuGame &board, const std::atomic<bool> &stop);
+
+    /** Search limits */
+    int time_budget_ms;
+    uint64_t node_limit;
+    bool search_can_abort;
+    bool search_aborted;
+    std::chrono::steady_clock::time_point search_deadline;
+
+    bool search_is_limited() const;
+    bool search_limit_reached();
+    void iterative_deepening(MoveEvaluation &result);
+    /** Search at the given depth, previous_score is the score of the previous iteration if there is one */
+    void search(MoveEvaluation &result, int search_depth, std::optional<int> previous_score = std::nullopt);
+
+    uint64_t transposition_key() const;
+
+    /** Return false when the move is illegal */
+    bool evaluateNode(const MoveHeuristic &move, int move_id, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremEval, std::pair<int, int> &best_move, bool isFirstMove);
 
     void minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bool maximizingPlayer);
     int score_player(Player player);
 
-    void compute_relevant_moves(std::vector<MoveHeuristic> &out_relevant_moves, int _depth) const;
+    void compute_relevant_moves(std::vector<MoveHeuristic> &out_relevant_moves, const std::pair<int, int> &first_move) const;
 
     int _heuristic_evaluation();
     void sortMoves(MoveEvaluation &eval, bool maximizingPlayer);
 
+    /** Structure values as integers, when they all are, so the evaluation can follow the count deltas of the moves */
+    bool incremental_evaluation;
+    int structure_values[StructureType::COUNT_STRUCTURE_TYPE];
+    /** Sum of the structure values of each player for the position being searched */
+    int structure_scores[3];
+
+    void reset_structure_scores();
+    /** Add the structure value changes of a played move, returns what to give to revert_structure_scores */
+    StructureScoreDelta apply_structure_scores(const MoveResult &move);
+    void revert_structure_scores(const StructureScoreDelta &delta);
+
     // std::vector<MoveHeuristic> get_relevant_moves(const GomokuGame &board);
 };
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace AI
+{
+
+/** Kind of score stored in a transposition entry */
+enum class TranspositionBound : uint8_t
+{
+    EXACT = 0,
+    LOWER = 1,
+    UPPER = 2,
+};
+
+/** Result of a search stored for a position */
+struct TranspositionEntry
+{
+    int score = 0;
+    int8_t depth = 0;
+    TranspositionBound bound = TranspositionBound::EXACT;
+    int8_t row = -1;
+    int8_t col = -1;
+
+    bool has_move() const { return row >= 0 && col >= 0; }
+};
+
+/** Fixed size hash table of searched positions indexed by their Zobrist key.
+ * The size is rounded down to a power of two so that the slot is found with a
+ * mask. An entry is replaced when a different position lands in its slot or
+ * when the same position is searched at least as deep.
+ *
+ * The table can be shared by several search threads without locks: a slot
+ * keeps the key xored with the data, so an entry torn by concurrent writes
+ * no longer matches its key and is seen as a miss.
+ */
+class TranspositionTable
+{
+public:
+    TranspositionTable(size_t size);
+
+    bool probe(uint64_t key, TranspositionEntry &out_entry) const;
+    void store(uint64_t key, const TranspositionEntry &entry);
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    static uint64_t pack(const TranspositionEntry &entry);
+    static TranspositionEntry unpack(uint64_t data);
+
+    std::unique_ptr<Slot[]> _slots;
+    size_t _size;
+    uint64_t _mask;
+};
+
+} // namespace AI
@@ -0,0 +1,339 @@
+#pragma once
+
+#include "gomoku_engine_types.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/** Orientation of the lines stored in the bitboard */
+enum BitboardLine : uint8_t
+{
+    ROWS = 0,
+    COLS = 1,
+    DIAGONALS = 2,      // row - col is constant
+    ANTI_DIAGONALS = 3, // row + col is constant
+    COUNT_BITBOARD_LINE,
+};
+
+/** Stones of both players stored as 64 bits masks, one for each row, column and diagonal of the board.
+ * Bit i of a line is the cell of column i, or of row i for the columns, so neighbours along any line
+ * are neighbouring bits and line queries are shifts and masks. Cells outside of the board are never set. */
+class GomokuBitboard
+{
+public:
+    /** Lines of the largest board: rows, columns and both diagonals */
+    static constexpr int max_lines = 6 * GOMOKU_MAX_BOARD_SIZE - 2;
+
+private:
+    int _width;
+    int _line_offsets[COUNT_BITBOARD_LINE + 1];
+    uint64_t _stones[2][max_lines];
+    /** Cells of each line that are on the board */
+    uint64_t _cells[max_lines];
+    /** Stones of each player that the opponent could capture along the line */
+    uint64_t _line_captures[2][max_lines];
+    /** Stones of each player that the opponent could capture along any line, in the layout of each line */
+    uint64_t _capturable[2][max_lines];
+    int _capturable_count[2];
+    /** Stones of each player placed or made uncapturable since the last find_uncapturable_five, one mask per row.
+     * Any uncapturable five of the player goes through one of them. */
+    uint64_t _five_candidates[2][GOMOKU_MAX_BOARD_SIZE];
+
+    static inline int player_slot(Player player) { return player - 1; }
+
+    inline int line_index(BitboardLine line, int row, int col) const
+    {
+        switch (line)
+        {
+        case ROWS:
+            return _line_offsets[ROWS] + row;
+        case COLS:
+            return _line_offsets[COLS] + col;
+        case DIAGONALS:
+            return _line_offsets[DIAGONALS] + row - col + _width - 1;
+        default:
+            return _line_offsets[ANTI_DIAGONALS] + row + col;
+        }
+    }
+
+    static inline int line_bit(BitboardLine line, int row, int col) { return line == COLS ? row : col; }
+
+    static inline BitboardLine line_of_direction(int row_dir, int col_dir)
+    {
+        if (row_dir == 0)
+            return ROWS;
+        if (col_dir == 0)
+            return COLS;
+        return row_dir == col_dir ? DIAGONALS : ANTI_DIAGONALS;
+    }
+
+    static inline uint64_t bits_between(int first, int last)
+    {
+        if (last < first)
+            return 0;
+        const int count = last - first + 1;
+        return (count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1) << first;
+    }
+
+    /** Cell of the given bit of a line */
+    inline void line_cell(BitboardLine line, int index, int bit, int &row, int &col) const
+    {
+        const int position = index - _line_offsets[line];
+        switch (line)
+        {
+        case ROWS:
+            row = position;
+            col = bit;
+            break;
+        case COLS:
+            row = bit;
+            col = position;
+            break;
+        case DIAGONALS:
+            row = position - _width + 1 + bit;
+            col = bit;
+            break;
+        default:
+            row = position - bit;
+            col = bit;
+            break;
+        }
+    }
+
+    /** Pairs of stones of the slot with an opponent stone on one side and an empty cell on the other */
+    inline uint64_t compute_line_captures(int slot, int index) const
+    {
+        const uint64_t own = _stones[slot][index];
+        const uint64_t other = _stones[1 - slot][index];
+        const uint64_t empty = _cells[index] & ~own & ~other;
+
+        const uint64_t pairs = own & (own >> 1) & (((other << 1) & (empty >> 2)) | ((empty << 1) & (other >> 2)));
+        return pairs | (pairs << 1);
+    }
+
+    /** Recompute the captures of the line, and the capturable bit of the cells that changed */
+    inline void update_line_captures(BitboardLine line, int index)
+    {
+        for (int slot = 0; slot < 2; ++slot)
+        {
+            const uint64_t captures = compute_line_captures(slot, index);
+            uint64_t changed = captures ^ _line_captures[slot][index];
+            _line_captures[slot][index] = captures;
+
+            while (changed)
+            {
+                const int bit = __builtin_ctzll(changed);
+                changed &= changed - 1;
+
+                int row;
+                int col;
+                line_cell(line, index, bit, row, col);
+                update_capturable(slot, row, col);
+            }
+        }
+    }
+
+    inline void update_capturable(int slot, int row, int col)
+    {
+        bool capturable = false;
+        for (int line = 0; line < COUNT_BITBOARD_LINE; ++line)
+            capturable = capturable || ((_line_captures[slot][line_index(BitboardLine(line), row, col)] >> line_bit(BitboardLine(line), row, col)) & 1);
+
+        if (capturable == bool((_capturable[slot][line_index(ROWS, row, col)] >> col) & 1))
+            return;
+
+        _capturable_count[slot] += capturable ? 1 : -1;
+        if (!capturable)
+            _five_candidates[slot][row] |= uint64_t(1) << col;
+        for (int line = 0; line < COUNT_BITBOARD_LINE; ++line)
+            _capturable[slot][line_index(BitboardLine(line), row, col)] ^= uint64_t(1) << line_bit(BitboardLine(line), row, col);
+    }
+
+    /** Is the stone on the cell part of five or more aligned stones of which none could be captured */
+    inline bool in_uncapturable_five(int slot, int row, int col) const
+    {
+        for (int line = 0; line < COUNT_BITBOARD_LINE; ++line)
+        {
+            const int index = line_index(BitboardLine(line), row, col);
+            const int bit = line_bit(BitboardLine(line), row, col);
+            const uint64_t stones = _stones[slot][index];
+
+            /** Length of the run of stones from the cell, upward and downward */
+            const uint64_t above = ~(stones >> bit);
+            const uint64_t below = ~(stones << (63 - bit));
+            const int first = bit - (below ? __builtin_clzll(below) : 64) + 1;
+            const int last = bit + (above ? __builtin_ctzll(above) : 64) - 1;
+
+            if (last - first + 1 >= 5 && !(bits_between(first, last) & _capturable[slot][index]))
+                return true;
+        }
+        return false;
+    }
+
+    /** Bits first to first + count - 1 of the mask, first may be negative */
+    static inline uint32_t extract(uint64_t mask, int first, int count)
+    {
+        const uint64_t shifted = first >= 0 ? (first < 64 ? mask >> first : 0) : mask << -first;
+        return uint32_t(shifted & ((uint64_t(1) << count) - 1));
+    }
+
+public:
+    GomokuBitboard(int width, int height)
+        : _width(width)
+    {
+        if (width > GOMOKU_MAX_BOARD_SIZE || height > GOMOKU_MAX_BOARD_SIZE)
+            throw std::invalid_argument("Board dimensions are limited to " + std::to_string(GOMOKU_MAX_BOARD_SIZE));
+        static_assert(GOMOKU_MAX_BOARD_SIZE <= 64, "Bitboard lines are 64 bits masks");
+
+        const int diagonals = std::max(0, width + height - 1);
+
+        _line_offsets[ROWS] = 0;
+        _line_offsets[COLS] = height;
+        _line_offsets[DIAGONALS] = height + width;
+        _line_offsets[ANTI_DIAGONALS] = height + width + diagonals;
+        _line_offsets[COUNT_BITBOARD_LINE] = height + width + 2 * diagonals;
+
+        for (int slot = 0; slot < 2; ++slot)
+        {
+            std::fill_n(_stones[slot], max_lines, 0);
+            std::fill_n(_line_captures[slot], max_lines, 0);
+            std::fill_n(_capturable[slot], max_lines, 0);
+            _capturable_count[slot] = 0;
+            std::fill_n(_five_candidates[slot], GOMOKU_MAX_BOARD_SIZE, 0);
+        }
+
+        std::fill_n(_cells, max_lines, 0);
+        for (int row = 0; row < height; ++row)
+            _cells[_line_offsets[ROWS] + row] = bits_between(0, width - 1);
+        for (int col = 0; col < width; ++col)
+            _cells[_line_offsets[COLS] + col] = bits_between(0, height - 1);
+        for (int line = 0; line < diagonals; ++line)
+        {
+            const int row_minus_col = line - width + 1;
+            _cells[_line_offsets[DIAGONALS] + line] = bits_between(std::max(0, -row_minus_col), std::min(width - 1, height - 1 - row_minus_col));
+            _cells[_line_offsets[ANTI_DIAGONALS] + line] = bits_between(std::max(0, line - height + 1), std::min(width - 1, line));
+        }
+    }
+
+    /** Moves the cell from old_value to new_value, EMPTY has no bits */
+    inline void set(int row, int col, Player old_value, Player new_value)
+    {
+        for (int line = 0; line < COUNT_BITBOARD_LINE; ++line)
+        {
+            const int index = line_index(BitboardLine(line), row, col);
+            const uint64_t bit = uint64_t(1) << line_bit(BitboardLine(line), row, col);
+
+            if (old_value != E)
+                _stones[player_slot(old_value)][index] &= ~bit;
+            if (new_value != E)
+                _stones[player_slot(new_value)][index] |= bit;
+        }
+        if (new_value != E)
+            _five_candidates[player_slot(new_value)][row] |= uint64_t(1) << col;
+
+        /** Captures only depend on the stones of their line */
+        for (int line = 0; line < COUNT_BITBOARD_LINE; ++line)
+            update_line_captures(BitboardLine(line), line_index(BitboardLine(line), row, col));
+    }
+
+    /** Stones of the player on the line of the given orientation going through the cell */
+    inline uint64_t line(Player player, BitboardLine line, int row, int col) const
+    {
+        return _stones[player_slot(player)][line_index(line, row, col)];
+    }
+
+    /** Cells of the line within radius of the cell, bit radius being the cell itself.
+     * stones gets the player stones, blocked the opponent stones and the cells out of the board. */
+    inline void window(Player player, BitboardLine line, int row, int col, int radius, uint32_t &stones, uint32_t &blocked) const
+    {
+        const int index = line_index(line, row, col);
+        const int first = line_bit(line, row, col) - radius;
+        const int count = 2 * radius + 1;
+
+        const uint32_t on_board = extract(_cells[index], first, count);
+
+        stones = extract(_stones[player_slot(player)][index], first, count);
+        blocked = extract(_stones[1 - player_slot(player)][index], first, count) | (~on_board & ((uint32_t(1) << count) - 1));
+    }
+
+    /** Would a stone of the player on the cell capture the two opponent stones in the direction */
+    inline bool captures(int row, int col, int row_dir, int col_dir, Player player) const
+    {
+        const BitboardLine line = line_of_direction(row_dir, col_dir);
+        const int index = line_index(line, row, col);
+        const int bit = line_bit(line, row, col);
+        const uint64_t own = _stones[player_slot(player)][index];
+        const uint64_t other = _stones[1 - player_slot(player)][index];
+
+        if ((line == COLS ? row_dir : col_dir) > 0)
+            return bit < 61 && ((other >> (bit + 1)) & 3) == 3 && ((own >> (bit + 3)) & 1);
+        return bit >= 3 && ((other >> (bit - 2)) & 3) == 3 && ((own >> (bit - 3)) & 1);
+    }
+
+    /** Could the opponent capture the stone of the player on the cell */
+    inline bool is_capturable(Player player, int row, int col) const
+    {
+        return (_capturable[player_slot(player)][line_index(ROWS, row, col)] >> col) & 1;
+    }
+
+    /** Could the opponent capture any stone of the player */
+    inline bool has_capturable_stones(Player player) const
+    {
+        return _capturable_count[player_slot(player)] > 0;
+    }
+
+    /** Does the player have five or more aligned stones of which none could be captured */
+    inline bool has_uncapturable_five(Player player) const
+    {
+        const int slot = player_slot(player);
+        for (int index = 0; index < _line_offsets[COUNT_BITBOARD_LINE]; ++index)
+        {
+            const uint64_t stones = _stones[slot][index];
+            const uint64_t starts = stones & (stones >> 1) & (stones >> 2) & (stones >> 3) & (stones >> 4);
+            uint64_t fives = starts | (starts << 1) | (starts << 2) | (starts << 3) | (starts << 4);
+
+            while (fives)
+            {
+                /** Adding the lowest bit clears the lowest run of set bits */
+                const uint64_t run = fives & ~(fives + (fives & -fives));
+                if (!(run & _capturable[slot][index]))
+                    return true;
+                fives &= ~run;
+            }
+        }
+        return false;
+    }
+
+    /** Same as has_uncapturable_five, but only looks at the lines through the stones placed or made uncapturable
+     * since the last call for the player. A five can't become uncapturable without one of them changing.
+     * Candidates are dropped once checked, up to the first one found in an uncapturable five. */
+    inline bool find_uncapturable_five(Player player)
+    {
+        const int slot = player_slot(player);
+        for (int row = 0; row < _line_offsets[COLS]; ++row)
+        {
+            uint64_t &candidates = _five_candidates[slot][row];
+            while (candidates)
+            {
+                const int col = __builtin_ctzll(candidates);
+                if (((_stones[slot][line_index(ROWS, row, col)] >> col) & 1) && in_uncapturable_five(slot, row, col))
+                    return true;
+                candidates &= candidates - 1;
+            }
+        }
+        return false;
+    }
+
+    /** Does the player have five or more aligned stones anywhere on the board */
+    inline bool has_five(Player player) const
+    {
+        for (int index = 0; index < _line_offsets[COUNT_BITBOARD_LINE]; ++index)
+        {
+            const uint64_t stones = _stones[player_slot(player)][index];
+            if (stones & (stones >> 1) & (stones >> 2) & (stones >> 3) & (stones >> 4))
+                return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "gomoku_engine_types.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+/** Set of board cells stored as a bitset per row. Insertion and removal are O(1),
+ * iteration is proportional to the number of cells and goes in row-major order.
+ * The bits are stored inline for the padded matrices of the largest board, so the set is trivially copyable. */
+class CellSet
+{
+public:
+    static constexpr int max_size = GOMOKU_MAX_BOARD_SIZE + 2;
+
+private:
+    static constexpr int max_words_per_row = (max_size + 63) / 64;
+
+    int _height;
+    int _words_per_row;
+    int _count;
+    uint64_t _bits[max_size * max_words_per_row] = {};
+
+    inline uint64_t &word(int row, int col) { return _bits[row * _words_per_row + (col >> 6)]; }
+    inline uint64_t word(int row, int col) const { return _bits[row * _words_per_row + (col >> 6)]; }
+    static inline uint64_t bit(int col) { return uint64_t(1) << (col & 63); }
+
+public:
+    CellSet() : _height(0), _words_per_row(0), _count(0) {}
+
+    CellSet(int width, int height)
+        : _height(height), _words_per_row((width + 63) / 64), _count(0)
+    {
+        if (width > max_size || height > max_size)
+            throw std::invalid_argument("Cell sets are limited to " + std::to_string(max_size) + "x" + std::to_string(max_size) + " cells");
+    }
+
+    inline bool contains(int row, int col) const
+    {
+        return word(row, col) & bit(col);
+    }
+
+    inline void insert(int row, int col)
+    {
+        uint64_t &w = word(row, col);
+        _count += !(w & bit(col));
+        w |= bit(col);
+    }
+
+    inline void erase(int row, int col)
+    {
+        uint64_t &w = word(row, col);
+        _count -= !!(w & bit(col));
+        w &= ~bit(col);
+    }
+
+    inline void clear()
+    {
+        std::fill_n(_bits, _height * _words_per_row, 0);
+        _count = 0;
+    }
+
+    inline int size() const { return _count; }
+    inline bool empty() const { return _count == 0; }
+
+    /** Calls f(row, col) for every cell of the set, row by row */
+    template <typename Function>
+    void for_each(Function f) const
+    {
+        for (int row = 0; row < _height; ++row)
+        {
+            for (int w = 0; w < _words_per_row; ++w)
+            {
+                uint64_t bits = _bits[row * _words_per_row + w];
+                while (bits)
+                {
+                    f(row, w * 64 + __builtin_ctzll(bits));
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+    /** Calls f(row, col) for the cells of the set, row by row, until it returns false.
+     * Returns whether every call returned true */
+    template <typename Predicate>
+    bool all_of(Predicate f) const
+    {
+        for (int row = 0; row < _height; ++row)
+        {
+            for (int w = 0; w < _words_per_row; ++w)
+            {
+                uint64_t bits = _bits[row * _words_per_row + w];
+                while (bits)
+                {
+                    if (!f(row, w * 64 + __builtin_ctzll(bits)))
+                        return false;
+                    bits &= bits - 1;
+                }
+            }
+        }
+        return true;
+    }
+};
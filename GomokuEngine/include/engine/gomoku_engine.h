@@ -1,55 +1,135 @@
 
 #pragma once
 
+#include "gomoku_bitboard.h"
+#include "gomoku_cell_set.h"
 #include "gomoku_engine_types.h"
+#include "gomoku_move_gains.h"
 #include "gomoku_pattern_reconizer.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "matrix/PaddedMatrix.hpp"
+#include <type_traits>
 
 #define RELEVANCY_LENGTH 2
 
-using CellSet = std::unordered_map<int, std::unordered_set<int>>;
+/** The board and the relevancy have a border as wide as the relevancy reaches, and share their offsets */
+typedef PaddedMatrix<Player, GOMOKU_MAX_BOARD_SIZE, GOMOKU_MAX_BOARD_SIZE, RELEVANCY_LENGTH> GomokuBoardMatrix;
+typedef PaddedMatrix<int8_t, GOMOKU_MAX_BOARD_SIZE, GOMOKU_MAX_BOARD_SIZE, RELEVANCY_LENGTH> GomokuRelevancyMatrix;
+static_assert(GomokuBoardMatrix::stride == GomokuRelevancyMatrix::stride, "Board and relevancy offsets are shared");
 
+/** Rule policies the move handling is specialised on */
+struct CaptureRules
+{
+    static constexpr bool capture_enabled = true;
+};
+
+struct NoCaptureRules
+{
+    static constexpr bool capture_enabled = false;
+};
+
+/** Board size and rules a specialisation of the move handling is compiled for.
+ * A Width and Height of 0 read the size from the game, for boards other than the standard one. */
+template <int Width, int Height, typename Rules>
+struct GomokuGameTraits
+{
+    static constexpr int width = Width;
+    static constexpr int height = Height;
+    static constexpr bool fixed_size = Width > 0 && Height > 0;
+    static constexpr bool capture_enabled = Rules::capture_enabled;
+};
+
+/** State of a game. Everything is stored inline for boards up to GOMOKU_MAX_BOARD_SIZE,
+ * so a game is trivially copyable: a snapshot is one block copy, which can live in a pool or shared memory.
+ * The move handling is compiled for the standard board with each rule set, with constant bounds and
+ * without the rule branches, and once more for any other size. The public methods dispatch to it. */
 class GomokuGame
 {
 private:
-    Matrix<Player> board;
+    GomokuBoardMatrix board;
+    GomokuBitboard _bitboard;
+    GomokuMoveGains _move_gains;
     GomokuCellIndex _min_played;
     GomokuCellIndex _max_played;
-    Matrix<int8_t> _relevancy_matrix;
+    GomokuRelevancyMatrix _relevancy_matrix;
     CellSet _relevant_cells;
 
     int empty_cells;
 
     Player current_player;
-    std::vector<int> players_scores;
+    std::array<int, 3> players_scores;
     bool is_game_over_flag;
     Player winner;
-    std::vector<GomokuPatternReconizer> players_reconizers;
+    /** Reconizers of black then white, see reconizer_of */
+    std::array<GomokuPatternReconizer, 2> players_reconizers;
     bool _capture_enabled;
+    uint64_t _hash;
+
+    /** Specialisation of the move handling picked at construction from the size and the rules.
+     * Kept as an index rather than a function pointer so the game stays a plain block of memory. */
+    enum Specialisation : uint8_t
+    {
+        STANDARD_CAPTURE,
+        STANDARD_NO_CAPTURE,
+        ANY_SIZE_CAPTURE,
+        ANY_SIZE_NO_CAPTURE,
+    };
+    Specialisation _specialisation;
+
+    /** Call the function with the GomokuGameTraits of the game */
+    template <typename Function>
+    decltype(auto) with_traits(Function &&function);
+
+    template <typename Traits>
+    bool coordinates_are_valid_as(int row, int col) const;
+    template <typename Traits>
+    CellChange set_board_value_as(int row, int col, Player value, bool updateRelevancyMatrix);
+    template <typename Traits>
+    MoveStatus try_make_move_as(int row, int col, MoveResult &move_result, bool updateRelevancyMatrix);
+    template <typename Traits>
+    void reverse_move_as(const MoveResult &move, bool updateRelevancyMatrix);
+    template <typename Traits>
+    void reapply_move_as(const MoveResult &move);
+    template <typename Traits>
+    void check_win_as(Player player);
+
+    inline GomokuPatternReconizer &reconizer_of(Player player) { return players_reconizers[player - 1]; }
+    inline const GomokuPatternReconizer &reconizer_of(Player player) const { return players_reconizers[player - 1]; }
 
     /** Relevancy */
     void update_relevancy(int8_t row, int8_t col, bool is_new_empty_cell);
 
     /** Capture */
-    bool try_direction_for_capture(int row, int col, int row_dir, int col_dir, Player player, MoveResult &move_result, bool updateRelevancyMatrix = true);
-    bool capture(int row, int col, Player player, MoveResult &move_result, bool updateRelevancyMatrix = true);
+    template <typename Traits>
+    bool try_direction_for_capture(int row, int col, int row_dir, int col_dir, Player player, MoveResult &move_result, bool updateRelevancyMatrix);
+    template <typename Traits>
+    bool capture(int row, int col, Player player, MoveResult &move_result, bool updateRelevancyMatrix);
+    bool can_capture(int row, int col, Player player) const;
 
     /** Board state */
 
     void modify_player_score(Player player, int score);
+    void set_current_player(Player player);
 
 public:
     GomokuGame(uint width, uint height, bool capture_enabled = true);
-    GomokuGame(const GomokuGame &copy);
+    GomokuGame(const GomokuGame &copy) = default;
 
-    GomokuGame &operator=(const GomokuGame &copy);
+    GomokuGame &operator=(const GomokuGame &copy) = default;
 
-    virtual ~GomokuGame();
+    ~GomokuGame() = default;
 
     bool is_game_over() const;
     MoveResult make_move(int row, int col, bool updateRelevancyMatrix = true);
+    /** Same as make_move but reports an illegal move instead of throwing */
+    MoveStatus try_make_move(int row, int col, MoveResult &move_result, bool updateRelevancyMatrix = true);
+    /** Would a stone of the player on this cell be refused as a double three, without playing it */
+    bool is_double_three(int row, int col, Player player) const;
     void reverse_move(const MoveResult &move, bool updateRelevancyMatrix = true);
+    /** Journal the pattern updates so reverse_move restores them instead of recomputing them.
+     * Moves made while journaling must be reversed in the reverse order they were made. */
+    void set_pattern_journaling(bool enabled);
+    /** Keep the move gains of every empty cell up to date with the board, see get_move_gains */
+    void set_move_gains_enabled(bool enabled);
     void reapply_move(const MoveResult &move);
     void check_win(Player player);
     Player get_winner() const;
@@ -63,17 +143,22 @@ public:
     Player other_player(Player player) const;
     Player get_current_player() const;
     int get_player_score(Player player) const;
+    /** Zobrist key of the position: stones, capture scores and side to move */
+    uint64_t get_hash() const;
+    const GomokuBitboard &get_bitboard() const;
+    const GomokuMoveGains &get_move_gains() const;
     CellChange set_board_value(int row, int col, Player value, bool updateRelevancyMatrix = true);
 
     std::pair<GomokuCellIndex, GomokuCellIndex> get_played_bounds(int margin = 0) const;
     bool has_player_bounds() const;
+    /** Empty cells with a stone within RELEVANCY_LENGTH, the candidate moves of the AIs */
     const CellSet &get_relevant_cells() const;
-    inline int8_t get_cell_relevancy(int row, int col) const { return _relevancy_matrix(row + 2, col + 2); }
+    inline int8_t get_cell_relevancy(int row, int col) const { return _relevancy_matrix(row, col); }
 
     const GomokuPatternReconizer &get_pattern_reconizer(Player player) const;
-    const std::vector<int> &get_patterns_count(Player player);
+    const StructureCounts &get_patterns_count(Player player);
     void print_patterns();
     std::vector<std::vector<int>> get_board() const;
 };
 
-bool cell_set_contains(const CellSet &cell_set, int row, int col);
+static_assert(std::is_trivially_copyable<GomokuGame>::value, "Games are copied as a block by the AIs and the rooms");
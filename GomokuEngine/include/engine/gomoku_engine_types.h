@@ -3,17 +3,30 @@
 
 #include "matrix/Matrix.hpp"
 #include "timer/Timer.h"
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+/** Largest board width and height, the front offers boards up to 25.
+ * The game state is stored inline for this size, so copying a game is a single block copy. */
+#ifndef GOMOKU_MAX_BOARD_SIZE
+#define GOMOKU_MAX_BOARD_SIZE 25
+#endif
+
+/** Size of the boards the rooms play on, the move handling is specialised for it */
+#define GOMOKU_STANDARD_BOARD_SIZE 19
+
 enum Player : uint8_t
 {
     EMPTY = 0,
     BLACK = 1,
     WHITE = 2,
+    /** Border of the padded board, never a stone */
+    OUTSIDE = 3,
 };
 
 #define X BLACK
@@ -39,6 +52,9 @@ enum StructureType : uint8_t
     COUNT_STRUCTURE_TYPE,
 };
 
+/** Number of structures of each type */
+typedef std::array<int, StructureType::COUNT_STRUCTURE_TYPE> StructureCounts;
+
 enum Pattern : uint8_t
 {
     FORK = 10,
@@ -56,9 +72,56 @@ struct CellChange
     Player new_value;
 };
 
+/** Outcome of a move attempt, only a successful move modifies the game */
+enum class MoveStatus : uint8_t
+{
+    SUCCESS,
+    INVALID_COORDINATES,
+    OCCUPIED_CELL,
+    DOUBLE_THREE,
+};
+
+std::ostream &operator<<(std::ostream &stream, MoveStatus status);
+
+/** Cells modified by a move, stored inline: the stone plus two captured stones in each of the 8 directions */
+struct CellChanges
+{
+    static constexpr int capacity = 1 + 8 * 2;
+
+    CellChange changes[capacity];
+    uint8_t count = 0;
+
+    void push_back(const CellChange &change)
+    {
+        changes[count++] = change;
+    }
+
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    CellChange &operator[](size_t index) { return changes[index]; }
+    const CellChange &operator[](size_t index) const { return changes[index]; }
+
+    CellChange *begin() { return changes; }
+    CellChange *end() { return changes + count; }
+    const CellChange *begin() const { return changes; }
+    const CellChange *end() const { return changes + count; }
+};
+
+/** Change of the structure counts of both players made by a move */
+struct PatternCountDelta
+{
+    int16_t counts[2][StructureType::COUNT_STRUCTURE_TYPE] = {};
+
+    int16_t *of(Player player) { return counts[player - 1]; }
+    const int16_t *of(Player player) const { return counts[player - 1]; }
+};
+
 struct MoveResult
 {
-    std::vector<CellChange> cell_changes;
+    CellChanges cell_changes;
+    PatternCountDelta pattern_count_delta;
 
     int8_t white_score_change = 0;
     int8_t black_score_change = 0;
@@ -66,3 +129,5 @@ struct MoveResult
     GomokuCellIndex previous_min_move;
     GomokuCellIndex previous_max_move;
 };
+
+static_assert(std::is_trivially_copyable<MoveResult>::value, "MoveResult is copied around the search and the room history");
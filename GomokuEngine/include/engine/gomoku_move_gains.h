@@ -0,0 +1,48 @@
+#pragma once
+
+#include "gomoku_bitboard.h"
+#include "gomoku_engine_types.h"
+#include "gomoku_window_reconizer.h"
+
+/** Gains of a stone played on a cell by one player */
+struct CellGains
+{
+    /** Structure the stone would make in each direction */
+    StructureType directions[PatternDirection::Count_PatternDirection];
+    /** Sum of the threat weights of the directions */
+    int threat;
+};
+
+/** Gains of every empty cell for both players, so moves can be ordered without being played.
+ * A stone only changes the windows of the cells at most window_radius away on its lines,
+ * so each board change reclassifies those cells with GomokuWindowReconizer.
+ * The table is disabled until enabled, and isn't updated while disabled. */
+class GomokuMoveGains
+{
+public:
+    GomokuMoveGains();
+
+    /** Rebuild the gains of every cell of the board, or drop them */
+    void set_enabled(bool enabled, const GomokuBitboard &bitboard, int width, int height);
+    inline bool is_enabled() const { return _enabled; }
+
+    /** Reclassify the cells whose windows contain the changed cell */
+    void update(const GomokuBitboard &bitboard, int row, int col);
+
+    inline const CellGains &gains(Player player, int row, int col) const
+    {
+        return _cells[player - 1][row * _width + col];
+    }
+
+    /** Weight of a structure in the threat score */
+    static int threat_weight(StructureType structure);
+
+private:
+    void update_cell(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction);
+    void set_gain(Player player, int row, int col, PatternDirection direction, StructureType gain);
+
+    bool _enabled;
+    int _width;
+    int _height;
+    CellGains _cells[2][GOMOKU_MAX_BOARD_SIZE * GOMOKU_MAX_BOARD_SIZE] = {};
+};
@@ -2,10 +2,10 @@
 #pragma once
 
 #include "gomoku_engine_types.h"
-#include "matrix/Matrix.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <functional>
-#include <unordered_map>
-#include <unordered_set>
 
 class GomokuGame;
 
@@ -34,58 +34,85 @@ std::ostream &operator<<(std::ostream &stream, PatternCellState cell_state);
  */
 struct PatternCellData
 {
-    PatternCellData() = default;
-
-    PatternCellData(uint16_t data);
+    constexpr PatternCellData() = default;
+
+    constexpr PatternCellData(uint16_t data) : _data(data)
+    {
+        assert((_data & 0b1100000000000000) == 0);
+    }
+
+    constexpr PatternCellData(uint8_t sequence_length,
+                              bool is_sequence_closed,
+                              uint8_t structure_length,
+                              bool is_structure_closed,
+                              uint8_t previous_structure_length,
+                              bool is_previous_structure_closed,
+                              bool is_gap_open_three,
+                              bool is_gap_open_three_closed)
+        : _data(0)
+    {
+        _data |= std::min(sequence_length, uint8_t(15));
+        _data |= is_sequence_closed ? 0b10000 : 0;
+        _data |= std::min(structure_length, uint8_t(7)) << 5;
+        _data |= is_structure_closed ? 0b100000000 : 0;
+        _data |= std::min(previous_structure_length, uint8_t(3)) << 9;
+        _data |= is_previous_structure_closed ? 0b100000000000 : 0;
+        _data |= is_gap_open_three ? 0b1000000000000 : 0;
+        _data |= is_gap_open_three_closed ? 0b10000000000000 : 0;
+
+        assert((_data & 0b1100000000000000) == 0);
+    }
+
+    /*
+     * IsClosGop(1) | IsGop(1) | PrevStructClos(1) | PrevStructLen(2) | StructClos(1) | StructLen(3) | SeqClos(1) | SeqLen(4)
+     * 0              0          0                   00                 0               000            0            0000
+     *  0  0  0 00 0 000 0 0000
+     * 13 12 11  9 8   5 4    0
+     */
 
-    PatternCellData(uint8_t sequence_length,
-                    bool is_sequence_closed,
-                    uint8_t structure_length,
-                    bool is_structure_closed,
-                    uint8_t previous_structure_length,
-                    bool is_previous_structure_closed,
-                    bool is_gap_open_three,
-                    bool is_gap_open_three_closed);
+    /** Number of distinct cell data, the 2 highest bits are never used */
+    static constexpr int combinations_count = 1 << 14;
 
     /** [0-15] Length of the potential sequence we're doing */
-    uint8_t sequence_length() const;
+    constexpr uint8_t sequence_length() const { return _data & 0b1111; }
     /** Define if the sequence bounded by an obstable at the begining */
-    bool is_sequence_closed() const;
+    constexpr bool is_sequence_closed() const { return (_data & 0b10000) != 0; }
 
     /** [0-7] Size of the structure ending on this cell.
      * 0 means no structure
      */
-    uint8_t structure_length() const;
+    constexpr uint8_t structure_length() const { return (_data & 0b11100000) >> 5; }
     /** Define if the structure is closed from one side.
      * If the structure is closed on both sides, it's not a structure.
      */
-    bool is_structure_closed() const;
+    constexpr bool is_structure_closed() const { return (_data & 0b100000000) != 0; }
 
     /** [0-3] Size of the structure that we're directly following.
      * This case is relevant to check for open three with gaps.
      */
-    uint8_t previous_structure_length() const;
+    constexpr uint8_t previous_structure_length() const { return (_data & 0b11000000000) >> 9; }
     /** Is the previous structure closed */
-    bool is_previous_structure_closed() const;
+    constexpr bool is_previous_structure_closed() const { return (_data & 0b100000000000) != 0; }
 
     /** Is gaped open three.
      * Handle niche case where we have sequence of open one and two
      */
-    bool is_gap_open_three() const;
+    constexpr bool is_gap_open_three() const { return (_data & 0b1000000000000) != 0; }
     /** Is the gaped open three closed. */
-    bool is_gap_open_three_closed() const;
+    constexpr bool is_gap_open_three_closed() const { return (_data & 0b10000000000000) != 0; }
 
-    bool operator!=(const PatternCellData &comp) const;
+    constexpr bool operator!=(const PatternCellData &comp) const { return _data != comp._data; }
 
-    static PatternCellData pre_bound_element();
+    static constexpr PatternCellData pre_bound_element() { return PatternCellData(0, true, 0, false, 0, false, false, false); }
 
     bool contains_structure() const;
 
     StructureType get_relevant_structure() const;
 
     void get_structures_type_count(std::vector<int> &array, int factor = 1) const;
+    void get_structures_type_count(int *array, int factor = 1) const;
 
-    uint16_t data() const;
+    constexpr uint16_t data() const { return _data; }
 
 private:
     uint16_t _data = 0;
@@ -93,8 +120,10 @@ private:
 
 std::ostream &operator<<(std::ostream &stream, const PatternCellData &cell_data);
 
+/** Cell of the pattern matrices, in board coordinates: -1 and the board size are the border */
 struct PatternCellIndex : public Matrix<PatternCellData>::Index
 {
+    PatternCellIndex() = default;
     PatternCellIndex(int row, int col);
     PatternCellIndex(GomokuCellIndex gomoku_index);
 };
@@ -110,42 +139,127 @@ enum PatternDirection : uint8_t
 
 std::ostream &operator<<(std::ostream &stream, PatternDirection direction);
 
+/** Pattern cells of one direction in board coordinates, with a border of bound cells around the board.
+ * Each line of the direction is stored contiguously in the order the direction walks it, so the
+ * next cell of a walk is the next element. A table shared by every matrix maps the cells to their offset,
+ * the layout is the one of the largest board whatever the size. */
+class PatternCellMatrix
+{
+public:
+    using Index = Matrix<PatternCellData>::Index;
+
+    static constexpr int padded_size = GOMOKU_MAX_BOARD_SIZE + 2;
+
+    /** Offset of each cell of the padded largest board in each direction */
+    struct LineOffsets
+    {
+        uint16_t offsets[PatternDirection::Count_PatternDirection][padded_size][padded_size];
+    };
+
+    PatternCellMatrix() : _direction(PatternDirection::LeftToRight), _width(0), _height(0) {}
+    PatternCellMatrix(PatternDirection direction, int width, int height);
+
+    /** Set every cell of the border to the sentinel */
+    void fill_border(const PatternCellData &sentinel);
+
+    /** Element getter */
+
+    inline PatternCellData &operator()(int row, int col)
+    {
+        assert(is_in_padded_bound(row, col));
+        return _cells[offset_of(row, col)];
+    }
+
+    inline const PatternCellData &operator()(int row, int col) const
+    {
+        assert(is_in_padded_bound(row, col));
+        return _cells[offset_of(row, col)];
+    }
+
+    inline PatternCellData &operator[](Index index) { return (*this)(index.row, index.col); }
+    inline const PatternCellData &operator[](Index index) const { return (*this)(index.row, index.col); }
+
+    /** Raw access by offset, the cell following an offset in the direction is at offset + 1 */
+
+    inline int offset_of(int row, int col) const
+    {
+        return _line_offsets.offsets[_direction][row + 1][col + 1];
+    }
+
+    inline PatternCellData &at(int offset) { return _cells[offset]; }
+    inline const PatternCellData &at(int offset) const { return _cells[offset]; }
+
+    /** Is the cell on the board, outside of the border */
+    inline bool is_in_bound(int row, int col) const
+    {
+        return row >= 0 && row < _height && col >= 0 && col < _width;
+    }
+
+    /** Is the cell on the board or its border */
+    inline bool is_in_padded_bound(int row, int col) const
+    {
+        return row >= -1 && row <= _height && col >= -1 && col <= _width;
+    }
+
+    inline PatternDirection get_direction() const { return _direction; }
+    inline int get_width() const { return _width; }
+    inline int get_height() const { return _height; }
+
+private:
+    static const LineOffsets _line_offsets;
+
+    PatternDirection _direction;
+    int _width;
+    int _height;
+    PatternCellData _cells[padded_size * padded_size];
+};
+
 class GomokuPatternReconizer
 {
 
 public:
     GomokuPatternReconizer(Player player);
-    GomokuPatternReconizer(const GomokuPatternReconizer &copy);
+    /** Everything is stored inline, a copy is a block copy */
+    GomokuPatternReconizer(const GomokuPatternReconizer &copy) = default;
 
-    GomokuPatternReconizer &operator=(const GomokuPatternReconizer &copy);
+    GomokuPatternReconizer &operator=(const GomokuPatternReconizer &copy) = default;
 
-    ~GomokuPatternReconizer();
+    ~GomokuPatternReconizer() = default;
 
     void find_patterns_in_board(const GomokuGame &board);
 
-    void update_patterns_with_move(const GomokuGame &board, const MoveResult &Count_move);
+    /** Update the patterns of both players after a move, walking each line once for the two of them.
+     * The update is journaled if journaling is on and journal is true. */
+    static void update_patterns_with_move(GomokuPatternReconizer &black, GomokuPatternReconizer &white, const GomokuGame &board, const MoveResult &Count_move, bool journal = true);
 
-    void print_patterns();
+    /** Record the cells overwritten by each move update, so the last move can be undone without walking the lines.
+     * Moves must then be undone in the reverse order they were made. Changing the mode clears the journal. */
+    void set_journaling(bool enabled);
+    /** Number of journaled move updates, including those that didn't fit in the journal */
+    size_t journaled_moves() const;
+    /** Restore the patterns of both players as they were before the last journaled move update.
+     * Returns false when the move didn't fit in the journal, the patterns must then be updated from the board. */
+    static bool undo_patterns_with_move(GomokuPatternReconizer &black, GomokuPatternReconizer &white);
 
-    const std::vector<int> &get_pattern_count() const;
+    void print_patterns();
 
-    bool five_or_more_cant_be_captured(const GomokuGame &board);
-    bool can_be_captured(const GomokuGame &board);
+    const StructureCounts &get_pattern_count() const;
 
     std::pair<StructureType, PatternCellIndex> get_structure_at(PatternCellIndex index, PatternDirection direction, int min_distance = 1, bool check_first_gap = true) const;
     StructureType highest_structure_around(PatternCellIndex index, int distance) const;
 
-    const Matrix<PatternCellData> &get_pattern_cell_matrix(PatternDirection direction) const;
+    /** Number of structures of a type gained by adding one of our stones at
+     * the index, computed without modifying the patterns. */
+    int structure_count_delta_with_stone(const GomokuGame &board, PatternCellIndex index, StructureType type) const;
+
+    const PatternCellMatrix &get_pattern_cell_matrix(PatternDirection direction) const;
 
 private:
     /** Return the state of a cell for our gomoku player */
     PatternCellState cell_state_at(const GomokuGame &board, PatternCellIndex index) const;
 
-    /** Calculate the next state from a cell when meeting each state. */
-    PatternCellData cell_data_following(const PatternCellData &cell, PatternCellState state) const;
-
-    /** Memoized version of cell_data_following */
-    const PatternCellData &cell_data_following_memoized(const PatternCellData &cell, PatternCellState state) const;
+    /** Calculate the next state from a cell when meeting each state, from a table generated at compile time */
+    static PatternCellData cell_data_following_memoized(PatternCellData cell, PatternCellState state);
 
     /** Check if pattern cell matrices are of the desired size or adjust them */
     bool adjust_matrices_size(const GomokuGame &board);
@@ -156,35 +270,63 @@ private:
     /** Update all cells of the matrices */
     void update_all_cells(const GomokuGame &board);
 
-    /** Update cell in all direction matrices */
-    void update_cell(const GomokuGame &board, PatternCellIndex index);
+    /** Update cell in all direction matrices of both players */
+    static void update_cell(GomokuPatternReconizer &black, GomokuPatternReconizer &white, const GomokuGame &board, PatternCellIndex index);
+
+    /** Store the new data of a cell, at offset in the direction matrix, return if it changed */
+    bool update_cell_direction(PatternCellIndex index, int offset, PatternDirection direction, const PatternCellData &new_data);
 
-    /** Update cells in the direction matrix at the specified location
+    /** Update cells in the direction matrix from the specified location
      *
      * up_to_bound: Should we update everything until the end or stop when
      * we find identical results.
      */
-    bool update_cell_direction(const GomokuGame &board, PatternCellIndex index, PatternDirection direction, PatternCellState new_state);
-    void update_cell_left_to_right(const GomokuGame &board, PatternCellIndex index, bool up_to_bound = false);
-    void update_cell_up_to_down(const GomokuGame &board, PatternCellIndex index, bool up_to_bound = false);
-    void update_cell_upleft_to_downright(const GomokuGame &board, PatternCellIndex index, bool up_to_bound = false);
-    void update_cell_upright_to_downleft(const GomokuGame &board, PatternCellIndex index, bool up_to_bound = false);
+    template <PatternDirection direction>
+    void update_cell_line(const GomokuGame &board, PatternCellIndex index, bool up_to_bound = false);
 
-    static PatternCellIndex get_index_offset(PatternCellIndex index, PatternDirection direction, int distance = 1);
-
-    void activate_tagging_mode();
+    /** Same as update_cell_line for both players at once, until both lines stop changing */
+    template <PatternDirection direction>
+    static void update_cell_line(GomokuPatternReconizer &black, GomokuPatternReconizer &white, const GomokuGame &board, PatternCellIndex index);
 
-    bool is_relevant_to_tag(const PatternCellData &data) const;
-    void untag_celldata_structure(PatternCellIndex index, PatternDirection direction);
-    void tag_celldata_structure(PatternCellIndex index, PatternDirection direction);
-
-    void for_each_tagged_structures(std::function<void(PatternCellIndex index, const PatternCellData &cell_data, PatternDirection direction, bool &should_continue)> lambda);
+    static PatternCellIndex get_index_offset(PatternCellIndex index, PatternDirection direction, int distance = 1);
 
-    bool is_structure_capturable(const GomokuGame &board, PatternCellIndex index, const PatternCellData &data, PatternDirection direction) const;
+    /** Walk the direction from the index to the end of the structure found there, see get_structure_at.
+     * With met_gap, a one or two followed by a gap isn't joined with the next structure. */
+    static std::pair<StructureType, PatternCellIndex> find_structure(const PatternCellMatrix &cell_matrix, PatternDirection direction, PatternCellIndex index, int distance, bool try_next, bool met_gap);
+
+    void begin_journaled_move();
+    bool undo_journaled_move();
+
+    /** Cells overwritten by the moves of a search path, beyond that moves are recomputed when undone */
+    static constexpr int journal_capacity = 512;
+    static constexpr int journal_moves_capacity = 32;
+
+    struct JournalEntry
+    {
+        PatternCellIndex index;
+        PatternDirection direction;
+        PatternCellData old_data;
+    };
+
+    struct JournalMove
+    {
+        /** Start of the move in _journal */
+        uint16_t start;
+        /** Were all the cells of the move recorded */
+        bool complete;
+        /** Pattern counts before the move */
+        StructureCounts counts;
+    };
 
     Player _gomoku_player;
-    std::vector<Matrix<PatternCellData>> _cell_matrices;
-    std::vector<std::unordered_map<int, std::unordered_set<int>>> _structure_maps;
-    std::vector<int> _cached_pattern_count;
-    bool _tagging_mode;
+    std::array<PatternCellMatrix, PatternDirection::Count_PatternDirection> _cell_matrices;
+    StructureCounts _cached_pattern_count;
+
+    bool _journaling;
+    JournalEntry _journal[journal_capacity];
+    int _journal_size;
+    JournalMove _journal_moves[journal_moves_capacity];
+    int _journal_moves_count;
+    /** Moves begun while _journal_moves was full */
+    int _journal_overflow_moves;
 };
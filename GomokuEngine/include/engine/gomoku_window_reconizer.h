@@ -0,0 +1,55 @@
+#pragma once
+
+#include "gomoku_bitboard.h"
+#include "gomoku_engine_types.h"
+#include "gomoku_pattern_reconizer.h"
+
+/** What a window tells about its center cell for one player. */
+struct WindowPattern
+{
+    /** Structure the center stone is part of, NONE if the center isn't one of our stones */
+    StructureType structure;
+    /** Structure the center would be part of if we played there, NONE if the center isn't empty */
+    StructureType gain;
+};
+
+/** Alternative to GomokuPatternReconizer classifying cells from the window of cells around them.
+ * The window_size cells of a line centered on a cell are read from the bitboard and encoded in
+ * base 3 (empty, stoned, blocked), the key indexes a table computed at compile time.
+ * It holds no state: the bitboard is already updated with each set_board_value, so each
+ * direction of a cell is classified with a few shifts and one lookup.
+ *
+ * Unlike the pattern cells, which are built from the start of the line, a window only
+ * looks at the structure going through its center: gaped threes are found on both sides
+ * of the center, an open three is preferred over a closed one.
+ */
+class GomokuWindowReconizer
+{
+public:
+    /** Cells on each side of the center in a window */
+    static constexpr int window_radius = 4;
+    static constexpr int window_size = 2 * window_radius + 1;
+    /** Number of distinct windows, 3 ^ window_size */
+    static constexpr int combinations_count = 19683;
+
+    GomokuWindowReconizer(Player player);
+
+    /** Classify the cell in one direction */
+    WindowPattern pattern_at(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction) const;
+
+    StructureType structure_at(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction) const;
+    StructureType gain_at(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction) const;
+
+    /** Best structure we would make in any direction by playing on the cell */
+    StructureType highest_gain_at(const GomokuBitboard &bitboard, int row, int col) const;
+
+    /** Classify the cells at distance -window_radius to window_radius from the cell in the direction, for both players.
+     * The bitboard is read once for the whole span, patterns of cells out of the board are meaningless. */
+    static void patterns_around(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction, WindowPattern *black_patterns, WindowPattern *white_patterns);
+
+    /** Base 3 key of the window centered on the cell, the first cell of the line being the lowest digit */
+    static int window_key(const GomokuBitboard &bitboard, Player player, int row, int col, PatternDirection direction);
+
+private:
+    Player _gomoku_player;
+};
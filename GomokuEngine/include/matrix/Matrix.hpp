@@ -19,7 +19,9 @@ public:
 
         Index(int r, int c) : row(r), col(c) {}
 
-        bool is_valid(const Matrix<Element> &matrix) const
+        /** Also accepts the matrices sharing this index, like PaddedMatrix */
+        template <typename AnyMatrix>
+        bool is_valid(const AnyMatrix &matrix) const
         {
             return matrix.is_in_bound(row, col);
         }
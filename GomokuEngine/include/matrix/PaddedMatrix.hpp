@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+/** Matrix with a border of Border cells on each side, stored inline for sizes up to MaxWidth x MaxHeight.
+ * Cells are addressed from -Border to size + Border - 1, the border holds a sentinel value so
+ * neighbours can be read without bounds checks.
+ * Rows are a power of two elements apart, at least 64 bytes, and start on a 64 bytes boundary.
+ * The offset of a cell only depends on the template parameters: matrices of the same stride and
+ * border share their offsets, and moving by (row_dir, col_dir) is adding row_dir * stride + col_dir. */
+template <typename Element, int MaxWidth, int MaxHeight, int Border>
+class PaddedMatrix
+{
+    static constexpr int round_to_power_of_two(int value, int power = 1)
+    {
+        return power >= value ? power : round_to_power_of_two(value, power * 2);
+    }
+
+    static constexpr int elements_per_cache_line = sizeof(Element) >= 64 ? 1 : int(64 / sizeof(Element));
+
+public:
+    using Index = typename Matrix<Element>::Index;
+
+    static constexpr int border = Border;
+    static constexpr int stride = round_to_power_of_two(MaxWidth + 2 * Border > elements_per_cache_line ? MaxWidth + 2 * Border : elements_per_cache_line);
+    static constexpr int padded_height = MaxHeight + 2 * Border;
+
+    /** Init */
+
+    PaddedMatrix() : _width(0), _height(0)
+    {
+    }
+
+    PaddedMatrix(int width, int height, const Element &sentinel = Element()) : _width(width), _height(height)
+    {
+        if (width < 0 || height < 0 || width > MaxWidth || height > MaxHeight)
+            throw std::invalid_argument("Matrix dimensions are limited to " + std::to_string(MaxWidth) + "x" + std::to_string(MaxHeight));
+        fill_border(sentinel);
+    }
+
+    /** Set every cell of the border to the sentinel */
+    void fill_border(const Element &sentinel)
+    {
+        for (int row = -Border; row < _height + Border; ++row)
+        {
+            for (int col = -Border; col < _width + Border; ++col)
+            {
+                if (!is_in_bound(row, col))
+                    _elements[offset_of(row, col)] = sentinel;
+            }
+        }
+    }
+
+    /** Element getter */
+
+    Element &operator()(int row, int col)
+    {
+        assert(is_in_padded_bound(row, col));
+        return _elements[offset_of(row, col)];
+    }
+
+    const Element &operator()(int row, int col) const
+    {
+        assert(is_in_padded_bound(row, col));
+        return _elements[offset_of(row, col)];
+    }
+
+    Element &operator[](Index index)
+    {
+        return (*this)(index.row, index.col);
+    }
+
+    const Element &operator[](Index index) const
+    {
+        return (*this)(index.row, index.col);
+    }
+
+    /** Raw access by offset, see offset_of */
+
+    static constexpr int offset_of(int row, int col)
+    {
+        return (row + Border) * stride + col + Border;
+    }
+
+    static constexpr int offset_of_direction(int row_dir, int col_dir)
+    {
+        return row_dir * stride + col_dir;
+    }
+
+    inline Element &at(int offset)
+    {
+        assert(offset >= 0 && offset < stride * padded_height);
+        return _elements[offset];
+    }
+
+    inline const Element &at(int offset) const
+    {
+        assert(offset >= 0 && offset < stride * padded_height);
+        return _elements[offset];
+    }
+
+    /** Is the cell on the board, outside of the border */
+    inline bool is_in_bound(int row, int col) const
+    {
+        return row >= 0 && row < _height && col >= 0 && col < _width;
+    }
+
+    /** Is the cell on the board or its border */
+    inline bool is_in_padded_bound(int row, int col) const
+    {
+        return row >= -Border && row < _height + Border && col >= -Border && col < _width + Border;
+    }
+
+    int get_width() const
+    {
+        return _width;
+    }
+
+    int get_height() const
+    {
+        return _height;
+    }
+
+private:
+    int _width;
+    int _height;
+    alignas(64) Element _elements[stride * padded_height] = {};
+};
@@ -67,6 +67,10 @@ struct GameEntitySetting
 {
     bool is_ai = false;
     std::string ai_name = "default";
+    /** Time allowed to the AI for each move in milliseconds. 0 searches at the depth of ai_name */
+    int time_budget_ms = 0;
+    /** Maximum number of nodes searched by the AI for each move. 0 means no limit */
+    uint64_t node_limit = 0;
 
     AI::IGomokuAI *make_ai() const;
 };
@@ -42,9 +42,10 @@ class Timer
 {
 private:
     using CallStack = std::vector<std::string>;
-    static std::map<CallStack, FunctionAccumulation> accumulatedFunctions;
-    static std::stack<CallStack> callStacks;
-    static std::map<std::string, int> activeFunctions;
+    // Per thread so that parallel searches can be timed, only the calling thread is reported
+    static thread_local std::map<CallStack, FunctionAccumulation> accumulatedFunctions;
+    static thread_local std::stack<CallStack> callStacks;
+    static thread_local std::map<std::string, int> activeFunctions;
 
     std::chrono::time_point<std::chrono::high_resolution_clock> start;
     CallStack currentCallStack;
@@ -36,7 +36,16 @@ std::vector<Move> GomokuAI::suggest_move_sequence(const GomokuGame &board)
 }
 
 GomokuAI::GomokuAI(const GomokuAiSettings &settings)
-    : game(0, 0), depth(settings.depth), length(settings.length), evaluation_data(settings.data)
+    : game(0, 0),
+      depth(settings.depth),
+      search_depth(settings.depth),
+      length(settings.length),
+      evaluation_data(settings.data),
+      time_budget_ms(settings.time_budget_ms),
+      node_limit(settings.node_limit),
+      searched_nodes(0),
+      search_can_abort(false),
+      search_aborted(false)
 {
     killer_moves = std::vector<std::pair<int, int>>(depth, {-1, -1});
 }
@@ -67,40 +76,42 @@ void sortMovesUtil(std::vector<MoveHeuristic> &moves, bool maximizingPlayer)
 void GomokuAI::sortMoves(std::vector<MoveHeuristic> &moves, bool maximizingPlayer, MoveEvaluation &eval)
 {
     TIMER
+    MoveResult game_move;
     for (auto it = moves.begin(); it != moves.end();) // no icrement here
     {
-        try
-        {
-            MoveResult game_move = game.make_move(it->row, it->col);
-            if (game.is_game_over())
-            {
-                if (game.get_winner() == ai_player)
-                    it->score = std::numeric_limits<int>::max();
-                else if (game.get_winner() == human_player)
-                    it->score = std::numeric_limits<int>::min();
-                else
-                    it->score = 0;
-            }
-            else
-                it->score = _heuristic_evaluation();
-            game.reverse_move(game_move);
-            ++it; // Only increment here if the move was successful
-        }
-        catch (std::exception &e)
+        if (game.try_make_move(it->row, it->col, game_move) != MoveStatus::SUCCESS)
         {
             it = moves.erase(it); // erase returns the next iterator
 #ifdef LOGGING
             eval.totalEvalCount--;
 #endif
+            continue;
         }
+
+        if (game.is_game_over())
+        {
+            if (game.get_winner() == ai_player)
+                it->score = std::numeric_limits<int>::max();
+            else if (game.get_winner() == human_player)
+                it->score = std::numeric_limits<int>::min();
+            else
+                it->score = 0;
+        }
+        else
+            it->score = _heuristic_evaluation();
+        game.reverse_move(game_move);
+        ++it; // Only increment here if the move was successful
     }
 
     sortMovesUtil(moves, maximizingPlayer);
 }
 
-void GomokuAI::evaluateNode(const MoveHeuristic &move, int moveId, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremeEval, std::pair<int, int> &best_move, bool isFirstMove)
+bool GomokuAI::evaluateNode(const MoveHeuristic &move, int moveId, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremeEval, std::pair<int, int> &best_move, bool isFirstMove)
 {
-    MoveResult game_move = game.make_move(move.row, move.col, _depth > 1);
+    MoveResult game_move;
+    if (game.try_make_move(move.row, move.col, game_move, _depth > 1) != MoveStatus::SUCCESS)
+        return false;
+
     eval.listMoves.push_back(MoveEvaluation());
     MoveEvaluation &evalNode = eval.listMoves.back();
     minimax(evalNode, _depth - 1, alpha, beta, !maximizingPlayer, move.row, move.col);
@@ -134,6 +145,7 @@ void GomokuAI::evaluateNode(const MoveHeuristic &move, int moveId, int _depth, M
 #endif
         }
     }
+    return true;
 }
 
 void GomokuAI::minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bool maximizingPlayer, int row, int col)
@@ -143,6 +155,9 @@ void GomokuAI::minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bo
     eval.move.first = row;
     eval.move.second = col;
 
+    if (search_limit_reached())
+        return;
+
     if (_depth == 0 || game.is_game_over())
     {
         if (game.is_game_over())
@@ -169,22 +184,17 @@ void GomokuAI::minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bo
     int extremeEval = maximizingPlayer ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
     std::pair<int, int> best_move = {-1, -1};
 
-    const std::pair<int, int> &killer_move = killer_moves[depth - _depth];
+    const std::pair<int, int> &killer_move = killer_moves[search_depth - _depth];
     if (killer_move.first == moves[0].row && killer_move.second == moves[0].col)
     {
-        try
+        if (evaluateNode(moves[0], 0, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove))
         {
-            evaluateNode(moves[0], 0, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove);
-
-            if (beta <= alpha)
+            if (beta <= alpha || search_aborted)
             {
                 return;
             }
             isFirstMove = false;
         }
-        catch (std::exception &e)
-        {
-        }
 #ifdef LOGGING
         eval.killerMoveHasBeenEvaluated = 1;
 #endif
@@ -197,26 +207,22 @@ void GomokuAI::minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bo
     int moveId = 0;
     while (moveId < moves.size())
     {
-        try
+        if (evaluateNode(moves[moveId], moveId, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove))
         {
-            evaluateNode(moves[moveId], moveId, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove);
-
-            if (beta <= alpha)
+            if (beta <= alpha || search_aborted)
             {
                 break;
             }
             isFirstMove = false;
         }
-        catch (std::exception &e)
-        {
-        }
         moveId++;
     }
 #ifdef LOGGING
     eval.evaluatedEvalCount = std::min((int)moves.size(), moveId + 1) + eval.killerMoveHasBeenEvaluated;
 #endif
 
-    killer_moves[depth - _depth] = {best_move.first, best_move.second};
+    if (!search_aborted)
+        killer_moves[search_depth - _depth] = {best_move.first, best_move.second};
 }
 
 int GomokuAI::_heuristic_evaluation()
@@ -228,7 +234,7 @@ int GomokuAI::_heuristic_evaluation()
 int GomokuAI::score_player(Player player)
 {
     int score = 0;
-    const std::vector<int> &patterns_count = game.get_patterns_count(player);
+    const StructureCounts &patterns_count = game.get_patterns_count(player);
 
     for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; i++)
     {
@@ -254,17 +260,86 @@ MoveEvaluation GomokuAI::suggest_move_evaluation(const GomokuGame &board)
     Timer timer(__FUNCTION__);
 
     game = board;
+    game.set_pattern_journaling(true);
     ai_player = board.get_current_player();
     human_player = board.other_player(ai_player);
 
+    searched_nodes = 0;
+    search_can_abort = false;
+    search_aborted = false;
+
     MoveEvaluation result;
-    if (board.has_player_bounds())
-        minimax(result, depth, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), true, -1, -1);
-    else
+    if (!board.has_player_bounds())
         result.listMoves.push_back(MoveEvaluation{{game.get_board_height() / 2, game.get_board_width() / 2}, 1});
+    else if (search_is_limited())
+        iterative_deepening(result);
+    else
+    {
+        search_depth = depth;
+        minimax(result, depth, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), true, -1, -1);
+    }
     return result;
 }
 
+/** Search one more ply at each iteration until a limit is reached.
+ * The best line of an iteration becomes the killer moves of the next one so
+ * that it is searched first. The first iteration always completes so that
+ * there is a move to return.
+ */
+void GomokuAI::iterative_deepening(MoveEvaluation &result)
+{
+    search_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_budget_ms);
+
+    for (int iteration_depth = 1; iteration_depth <= depth; ++iteration_depth)
+    {
+        MoveEvaluation iteration;
+        search_depth = iteration_depth;
+        minimax(iteration, iteration_depth, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), true, -1, -1);
+
+        if (search_aborted)
+            break;
+
+        result = std::move(iteration);
+        search_can_abort = true;
+
+        const int best_index = getBestMoveIndex(result, true);
+        if (best_index == -1)
+            break;
+        const int best_score = result.listMoves[best_index].score;
+        if (best_score == std::numeric_limits<int>::max() || best_score == std::numeric_limits<int>::min())
+            break;
+
+        MoveEvaluation *node = &result;
+        bool maximizing = true;
+        for (int ply = 0; ply < iteration_depth && node->listMoves.size() > 0; ++ply)
+        {
+            node = &getBestMoveEvaluation(*node, maximizing);
+            killer_moves[ply] = node->move;
+            maximizing = !maximizing;
+        }
+    }
+}
+
+bool GomokuAI::search_is_limited() const
+{
+    return time_budget_ms > 0 || node_limit > 0;
+}
+
+bool GomokuAI::search_limit_reached()
+{
+    searched_nodes++;
+
+    if (search_aborted || !search_can_abort)
+        return search_aborted;
+
+    if (node_limit > 0 && searched_nodes >= node_limit)
+        search_aborted = true;
+    else if (time_budget_ms > 0 && (searched_nodes & 0xff) == 0 && std::chrono::steady_clock::now() >= search_deadline)
+        search_aborted = true;
+
+    return search_aborted;
+}
+
 static const std::vector<std::pair<int, int>> _directions_offsets = {
     {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
 
@@ -272,22 +347,21 @@ void GomokuAI::find_relevant_moves(std::vector<MoveHeuristic> &out_relevant_move
 {
     TIMER
 
+    const CellSet &relevant_cells = game.get_relevant_cells();
     auto [min, max] = game.get_played_bounds(length);
-    out_relevant_moves.reserve((max.row - min.row + 1) * (max.col - min.col + 1));
+    out_relevant_moves.reserve(relevant_cells.size());
 
-    const auto &killer_move = killer_moves[depth - _depth];
-    for (int row = min.row; row <= max.row; ++row)
-    {
-        for (int col = min.col; col <= max.col; ++col)
+    const auto &killer_move = killer_moves[search_depth - _depth];
+    relevant_cells.for_each(
+        [&](int row, int col)
         {
-            if (game.get_cell_relevancy(row, col) <= 0 || game.get_board_value(row, col) != E)
-                continue;
-            if (killer_move == std::pair<int, int>(row , col))
+            if (row < min.row || row > max.row || col < min.col || col > max.col)
+                return;
+            if (killer_move == std::pair<int, int>(row, col))
                 out_relevant_moves.emplace(out_relevant_moves.begin(), MoveHeuristic{uint8_t(row), uint8_t(col), 0});
             else
                 out_relevant_moves.emplace_back(MoveHeuristic{uint8_t(row), uint8_t(col), 0});
-        }
-    }
+        });
 }
 
 
@@ -318,6 +392,7 @@ std::vector<MoveHeuristic> GomokuAI::get_relevant_moves(const GomokuGame &board)
     human_player = board.other_player(ai_player);
 
     std::vector<MoveHeuristic> moves;
+    search_depth = depth;
     find_relevant_moves(moves, depth);
     return moves;
 }
@@ -1,7 +1,10 @@
 #include "ai/gomoku_ai_minmaxv3.h"
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <random>
+#include <stdexcept>
+#include <thread>
 #include <utility>
 
 #include "utils/gomoku_utilities.h"
@@ -15,6 +18,12 @@
 namespace AI::MinMaxV3
 {
 
+/** Plies searched past the leaves of the principal variation when deepening */
+static const int deepening_depth = 4;
+
+/** Scores are stored from the AI point of view, so the key depends on it */
+static const uint64_t ai_player_key = 0x5bd1e9955bd1e995ULL;
+
 Move GomokuAI::suggest_move(const GomokuGame &board, int currentMove)
 {
 #ifdef LOGGING
@@ -43,9 +52,55 @@ std::vector<Move> GomokuAI::suggest_move_sequence(const GomokuGame &board)
 }
 
 GomokuAI::GomokuAI(const GomokuAiSettings &settings)
-    : game(0, 0), depth(settings.depth), length(settings.length), evaluation_data(settings.data)
+    : game(0, 0),
+      depth(settings.depth),
+      length(settings.length),
+      evaluation_data(settings.data),
+      ply(0),
+      gain_move_ordering(settings.gain_move_ordering),
+      principal_variation_search(settings.principal_variation_search),
+      aspiration_window(settings.aspiration_window),
+      transposition_width(0),
+      transposition_height(0),
+      helper_id(0),
+      stop_signal(nullptr),
+      time_budget_ms(settings.time_budget_ms),
+      node_limit(settings.node_limit),
+      search_can_abort(false),
+      search_aborted(false)
 {
-    killer_moves = std::vector<std::pair<int, int>>(depth, {-1, -1});
+    killer_moves = std::vector<std::pair<int, int>>(depth + deepening_depth, {-1, -1});
+
+    /** Integral values sum the same in any order, others are summed from the counts at each evaluation */
+    incremental_evaluation = true;
+    for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; ++i)
+    {
+        const float value = evaluation_data.value_of_structure(i);
+        structure_values[i] = int(value);
+        incremental_evaluation = incremental_evaluation && float(structure_values[i]) == value && std::abs(value) < (1 << 20);
+    }
+    if (settings.threads > 1 && settings.transposition_table_size == 0)
+        throw std::invalid_argument("Helper threads share the transposition table, it can't be disabled");
+    if (settings.transposition_table_size > 0)
+        transposition_table = std::make_shared<TranspositionTable>(settings.transposition_table_size);
+
+    if (!transposition_table)
+        return;
+
+    for (int id = 1; id < settings.threads; ++id)
+    {
+        GomokuAiSettings helper_settings = settings;
+        // Half of the helpers search one ply deeper
+        helper_settings.depth = depth + id % 2;
+        helper_settings.transposition_table_size = 0;
+        helper_settings.time_budget_ms = 0;
+        helper_settings.node_limit = 0;
+        helper_settings.threads = 1;
+
+        helpers.push_back(std::make_unique<GomokuAI>(helper_settings));
+        helpers.back()->transposition_table = transposition_table;
+        helpers.back()->helper_id = id;
+    }
 }
 
 void sortMovesUtil(MoveEvaluation &eval, bool maximizingPlayer)
@@ -74,37 +129,76 @@ void sortMovesUtil(MoveEvaluation &eval, bool maximizingPlayer)
 void GomokuAI::sortMoves(MoveEvaluation &eval, bool maximizingPlayer)
 {
     TIMER
-    for (auto it = eval.relevant_moves.begin(); it != eval.relevant_moves.end();) // no icrement here
+    if (gain_move_ordering)
     {
-        try
+        /** Making our threats or blocking the opponent ones, ours count twice as they may win first */
+        constexpr int capture_gain = 300;
+        const GomokuMoveGains &move_gains = game.get_move_gains();
+        const Player player = game.get_current_player();
+        const Player opponent = game.other_player(player);
+        for (auto it = eval.relevant_moves.begin(); it != eval.relevant_moves.end();)
         {
-            MoveResult game_move = game.make_move(it->row, it->col);
-            if (game.is_game_over())
+            /** Illegal moves are dropped like when they're played */
+            if (game.is_double_three(it->row, it->col, player))
             {
-                if (game.get_winner() == ai_player)
-                    it->score = std::numeric_limits<int>::max();
-                else if (game.get_winner() == human_player)
-                    it->score = std::numeric_limits<int>::min();
-                else
-                    it->score = 0;
+                it = eval.relevant_moves.erase(it);
+                continue;
             }
-            else
-                it->score = _heuristic_evaluation();
-            game.reverse_move(game_move);
-            ++it; // Only increment here if the move was successful
+
+            int gain = 2 * move_gains.gains(player, it->row, it->col).threat + move_gains.gains(opponent, it->row, it->col).threat;
+
+            /** Captures aren't structures, they're looked up on the bitboard */
+            for (int row_dir = -1; row_dir <= 1; ++row_dir)
+            {
+                for (int col_dir = -1; col_dir <= 1; ++col_dir)
+                {
+                    if ((row_dir != 0 || col_dir != 0) && game.get_bitboard().captures(it->row, it->col, row_dir, col_dir, player))
+                        gain += capture_gain;
+                }
+            }
+            it->score = maximizingPlayer ? gain : -gain;
+            ++it;
         }
-        catch (std::exception &e)
+        sortMovesUtil(eval, maximizingPlayer);
+        return;
+    }
+
+    MoveResult game_move;
+    for (auto it = eval.relevant_moves.begin(); it != eval.relevant_moves.end();) // no icrement here
+    {
+        if (game.try_make_move(it->row, it->col, game_move) != MoveStatus::SUCCESS)
         {
             it = eval.relevant_moves.erase(it); // erase returns the next iterator
+            continue;
         }
+        const StructureScoreDelta score_delta = apply_structure_scores(game_move);
+
+        if (game.is_game_over())
+        {
+            if (game.get_winner() == ai_player)
+                it->score = std::numeric_limits<int>::max();
+            else if (game.get_winner() == human_player)
+                it->score = std::numeric_limits<int>::min();
+            else
+                it->score = 0;
+        }
+        else
+            it->score = _heuristic_evaluation();
+        revert_structure_scores(score_delta);
+        game.reverse_move(game_move);
+        ++it; // Only increment here if the move was successful
     }
 
     sortMovesUtil(eval, maximizingPlayer);
 }
 
-void GomokuAI::evaluateNode(const MoveHeuristic &move, int move_id, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremeEval, std::pair<int, int> &best_move, bool isFirstMove)
+bool GomokuAI::evaluateNode(const MoveHeuristic &move, int move_id, int _depth, MoveEvaluation &eval, int &alpha, int &beta, bool maximizingPlayer, int &extremeEval, std::pair<int, int> &best_move, bool isFirstMove)
 {
-    MoveResult game_move = game.make_move(move.row, move.col, _depth > 1);
+    MoveResult game_move;
+    if (game.try_make_move(move.row, move.col, game_move, _depth > 1) != MoveStatus::SUCCESS)
+        return false;
+    const StructureScoreDelta score_delta = apply_structure_scores(game_move);
+
     MoveEvaluation *evalNode = nullptr;
 
     if (deepening)
@@ -116,7 +210,29 @@ void GomokuAI::evaluateNode(const MoveHeuristic &move, int move_id, int _depth,
         eval.listMoves.emplace_back(MoveEvaluation{move.row, move.col}); // Use emplace_back for efficiency
         evalNode = &eval.listMoves.back();
     }
-    minimax(*evalNode, _depth - 1, alpha, beta, !maximizingPlayer);
+    ply++;
+    /** A move after the first one only has to be proven worse than the best one, with a null window.
+     * The window is already null when the parent is searched with one. */
+    const bool null_window = principal_variation_search && !isFirstMove && !deepening && int64_t(beta) - int64_t(alpha) > 1;
+    if (null_window)
+    {
+        if (maximizingPlayer)
+            minimax(*evalNode, _depth - 1, alpha, alpha + 1, !maximizingPlayer);
+        else
+            minimax(*evalNode, _depth - 1, beta - 1, beta, !maximizingPlayer);
+
+        /** The score is only a bound, the move is searched again if it may be better but not cut */
+        if (evalNode->score > alpha && evalNode->score < beta && !search_aborted)
+        {
+            statistics.pvs_researches++;
+            *evalNode = MoveEvaluation{move.row, move.col};
+            minimax(*evalNode, _depth - 1, alpha, beta, !maximizingPlayer);
+        }
+    }
+    else
+        minimax(*evalNode, _depth - 1, alpha, beta, !maximizingPlayer);
+    ply--;
+    revert_structure_scores(score_delta);
     game.reverse_move(game_move, _depth > 1);
     if (maximizingPlayer)
     {
@@ -140,13 +256,19 @@ void GomokuAI::evaluateNode(const MoveHeuristic &move, int move_id, int _depth,
             eval.best_move_id = move_id;
         }
     }
+    return true;
 }
 
 void GomokuAI::minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bool maximizingPlayer)
 {
     TIMER
+    statistics.nodes++;
 
-    if (_depth == 0 || game.is_game_over())
+    if (search_limit_reached())
+        return;
+
+    /** A node cut by the transposition table has no children to follow when deepening */
+    if (_depth == 0 || game.is_game_over() || (deepening && eval.listMoves.empty()))
     {
         if (game.is_game_over())
         {
@@ -168,7 +290,7 @@ void GomokuAI::minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bo
             {
                 deepening = false;
                 int initial_score = eval.score;
-                minimax(eval, 4, alpha, beta, maximizingPlayer);
+                minimax(eval, deepening_depth, alpha, beta, maximizingPlayer);
                 deepened_move_score = eval.score;
 
                 if (eval.score >= initial_score)
@@ -183,60 +305,115 @@ void GomokuAI::minimax(MoveEvaluation &eval, int _depth, int alpha, int beta, bo
         return;
     }
 
+    /** Nodes searched while deepening only follow the best move, their result can't be reused */
+    const bool use_transposition = transposition_table && !deepening;
+    const uint64_t key = use_transposition ? transposition_key() : 0;
+    const int alpha_origin = alpha;
+    const int beta_origin = beta;
+    std::pair<int, int> first_move = killer_moves[ply];
+
+    if (use_transposition)
+    {
+        TranspositionEntry entry;
+        if (transposition_table->probe(key, entry))
+        {
+            statistics.tt_hits++;
+            /** The root keeps its children to be able to return a move */
+            if (ply > 0 && entry.depth >= _depth && (entry.bound == TranspositionBound::EXACT || (entry.bound == TranspositionBound::LOWER && entry.score >= beta) || (entry.bound == TranspositionBound::UPPER && entry.score <= alpha)))
+            {
+                statistics.tt_cutoffs++;
+                eval.score = entry.score;
+                return;
+            }
+            if (entry.has_move())
+                first_move = {entry.row, entry.col};
+        }
+    }
+
     if (eval.relevant_moves.size() == 0)
-        compute_relevant_moves(eval.relevant_moves, _depth);
+        compute_relevant_moves(eval.relevant_moves, first_move);
+
+    if (eval.relevant_moves.size() == 0)
+    {
+        eval.score = _heuristic_evaluation();
+        return;
+    }
 
     bool isFirstMove = true;
+    bool cutoff = false;
     int extremeEval = maximizingPlayer ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
     std::pair<int, int> best_move = {-1, -1};
 
     if (!deepening)
     {
-        const std::pair<int, int> &killer_move = killer_moves[depth - _depth];
-        if (killer_move.first == eval.relevant_moves[0].row && killer_move.second == eval.relevant_moves[0].col)
+        if (first_move.first == eval.relevant_moves[0].row && first_move.second == eval.relevant_moves[0].col)
         {
-            try
+            if (evaluateNode(eval.relevant_moves[0], eval.cur_move_id, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove))
             {
-                evaluateNode(eval.relevant_moves[0], eval.cur_move_id, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove);
-
-                if (beta <= alpha)
-                {
-                    return;
-                }
+                cutoff = beta <= alpha || search_aborted;
                 isFirstMove = false;
             }
-            catch (std::exception &e)
-            {
-            }
-            eval.cur_move_id++;
+            if (!cutoff)
+                eval.cur_move_id++;
         }
     }
 
-    if (_depth > 1 && !deepening)
-        sortMoves(eval, maximizingPlayer);
-
-    if (deepening)
-        eval.cur_move_id = eval.best_move_id;
-
-    while (eval.cur_move_id < eval.relevant_moves.size())
+    if (!cutoff)
     {
-        try
+        if (_depth > 1 && !deepening)
+            sortMoves(eval, maximizingPlayer);
+
+        // Helpers start with different root moves so that they don't all search the same tree
+        if (ply == 0 && helper_id > 0 && !deepening && eval.cur_move_id < int(eval.relevant_moves.size()))
         {
-            evaluateNode(eval.relevant_moves[eval.cur_move_id], eval.cur_move_id, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove);
+            auto first = eval.relevant_moves.begin() + eval.cur_move_id;
+            std::rotate(first, first + helper_id % (eval.relevant_moves.end() - first), eval.relevant_moves.end());
+        }
 
-            if (beta <= alpha)
+        if (deepening)
+            eval.cur_move_id = eval.best_move_id;
+
+        while (eval.cur_move_id < int(eval.relevant_moves.size()))
+        {
+            if (evaluateNode(eval.relevant_moves[eval.cur_move_id], eval.cur_move_id, _depth, eval, alpha, beta, maximizingPlayer, extremeEval, best_move, isFirstMove))
             {
-                break;
+                if (beta <= alpha || search_aborted)
+                {
+                    break;
+                }
+                isFirstMove = false;
             }
-            isFirstMove = false;
-        }
-        catch (std::exception &e)
-        {
+            eval.cur_move_id++;
         }
-        eval.cur_move_id++;
+
+        if (!search_aborted)
+            killer_moves[ply] = {best_move.first, best_move.second};
+    }
+
+    /** An aborted search leaves partial scores that must not be stored.
+     * The root move of a helper is only the first one to reach the root bound
+     * in its own move order, it must not be tried first by the main search. */
+    const bool is_helper_root = helper_id > 0 && ply == 0;
+    if (use_transposition && best_move.first >= 0 && !search_aborted && !is_helper_root)
+    {
+        TranspositionEntry entry;
+        entry.score = eval.score;
+        entry.depth = _depth;
+        if (eval.score >= beta_origin)
+            entry.bound = TranspositionBound::LOWER;
+        else if (eval.score <= alpha_origin)
+            entry.bound = TranspositionBound::UPPER;
+        else
+            entry.bound = TranspositionBound::EXACT;
+        entry.row = best_move.first;
+        entry.col = best_move.second;
+        transposition_table->store(key, entry);
     }
+}
 
-    killer_moves[depth - _depth] = {best_move.first, best_move.second};
+uint64_t GomokuAI::transposition_key() const
+{
+    return game.get_hash() ^ (ai_player == O ? ai_player_key : 0);
 }
 
 int GomokuAI::_heuristic_evaluation()
@@ -248,22 +425,65 @@ int GomokuAI::_heuristic_evaluation()
 int GomokuAI::score_player(Player player)
 {
     int score = 0;
-    const std::vector<int> &patterns_count = game.get_patterns_count(player);
+    const StructureCounts &patterns_count = game.get_patterns_count(player);
 
-    for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; i++)
+    if (incremental_evaluation)
+        score = structure_scores[player];
+    else
     {
-        score += patterns_count[i] * evaluation_data.value_of_structure(i);
+        for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; i++)
+        {
+            score += patterns_count[i] * evaluation_data.value_of_structure(i);
+        }
     }
     score += (patterns_count[OPEN_THREE] + patterns_count[FOUR] + patterns_count[OPEN_FOUR] >= 2) ? evaluation_data.value_of_multiple_forced() : 0;
     score += evaluation_data.value_of_captures(game.get_player_score(player));
     return score;
 }
 
+void GomokuAI::reset_structure_scores()
+{
+    for (Player player : {X, O})
+    {
+        const StructureCounts &patterns_count = game.get_patterns_count(player);
+
+        structure_scores[player] = 0;
+        for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; i++)
+            structure_scores[player] += patterns_count[i] * structure_values[i];
+    }
+}
+
+StructureScoreDelta GomokuAI::apply_structure_scores(const MoveResult &move)
+{
+    StructureScoreDelta delta;
+    if (!incremental_evaluation)
+        return delta;
+
+    const int16_t *black_counts = move.pattern_count_delta.of(X);
+    const int16_t *white_counts = move.pattern_count_delta.of(O);
+    for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; i++)
+    {
+        delta.black += black_counts[i] * structure_values[i];
+        delta.white += white_counts[i] * structure_values[i];
+    }
+
+    structure_scores[X] += delta.black;
+    structure_scores[O] += delta.white;
+    return delta;
+}
+
+void GomokuAI::revert_structure_scores(const StructureScoreDelta &delta)
+{
+    structure_scores[X] -= delta.black;
+    structure_scores[O] -= delta.white;
+}
+
 int GomokuAI::get_heuristic_evaluation(const GomokuGame &board, Player player)
 {
     TIMER
 
     game = board;
+    reset_structure_scores();
     ai_player = player;
     human_player = board.other_player(player);
     return _heuristic_evaluation();
@@ -273,77 +493,218 @@ MoveEvaluation GomokuAI::suggest_move_evaluation(const GomokuGame &board)
 {
     Timer timer(__FUNCTION__);
 
+    /** The same stones on another board size evaluate differently, and the best moves differ */
+    if (board.get_board_width() != transposition_width || board.get_board_height() != transposition_height)
+    {
+        if (transposition_table)
+            transposition_table->clear();
+        std::fill(killer_moves.begin(), killer_moves.end(), std::make_pair(-1, -1));
+        transposition_width = board.get_board_width();
+        transposition_height = board.get_board_height();
+    }
+
+    game = board;
+    game.set_pattern_journaling(true);
+    game.set_move_gains_enabled(gain_move_ordering);
+    reset_structure_scores();
+    ai_player = board.get_current_player();
+    human_player = board.other_player(ai_player);
+    ply = 0;
+    statistics = SearchStatistics();
+    search_can_abort = false;
+    search_aborted = false;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<bool> stop_helpers(false);
+    std::vector<std::thread> helper_threads;
+
+    MoveEvaluation result;
+    if (!board.has_player_bounds())
+        result.listMoves.push_back(MoveEvaluation{game.get_board_height() / 2, game.get_board_width() / 2});
+    else
+    {
+        for (auto &helper : helpers)
+            helper_threads.emplace_back(&GomokuAI::run_helper, helper.get(), std::cref(board), std::cref(stop_helpers));
+
+        if (search_is_limited())
+            iterative_deepening(result);
+        else
+            search(result, depth);
+    }
+
+    stop_helpers = true;
+    for (auto &thread : helper_threads)
+        thread.join();
+
+    statistics.threads = 1 + helper_threads.size();
+    for (size_t i = 0; i < helper_threads.size(); ++i)
+        statistics.helper_nodes += helpers[i]->statistics.nodes;
+    statistics.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/** Deepen the search of the position until the main search stops the helper */
+void GomokuAI::run_helper(const GomokuGame &board, const std::atomic<bool> &stop)
+{
     game = board;
+    game.set_pattern_journaling(true);
+    game.set_move_gains_enabled(gain_move_ordering);
+    reset_structure_scores();
     ai_player = board.get_current_player();
     human_player = board.other_player(ai_player);
+    ply = 0;
+    statistics = SearchStatistics();
+    stop_signal = &stop;
+    search_can_abort = true;
+    search_aborted = false;
+
+    std::optional<int> previous_score;
+    for (int iteration_depth = 1; iteration_depth <= depth && !search_aborted; ++iteration_depth)
+    {
+        MoveEvaluation iteration;
+        search(iteration, iteration_depth, previous_score);
+        previous_score = iteration.score;
+    }
+}
+
+void GomokuAI::search(MoveEvaluation &result, int search_depth, std::optional<int> previous_score)
+{
     deepening = false;
     deepening_successful = false;
     deepened_move_score = 0;
 
-    MoveEvaluation result;
     result.initial_score = _heuristic_evaluation();
     result.score = std::numeric_limits<int>::max();
-    if (board.has_player_bounds())
+
+    /** The root looks for a move keeping the score of the position. With an aspiration window
+     * it first looks around the score of the previous iteration, the side of the window
+     * the score falls out of is then opened and the root searched again. */
+    int alpha = std::numeric_limits<int>::min();
+    int beta = result.initial_score;
+    const bool aspiration = aspiration_window > 0 && previous_score && *previous_score != std::numeric_limits<int>::min() && *previous_score != std::numeric_limits<int>::max();
+    if (aspiration)
     {
-        while (result.score >= result.initial_score && !deepening_successful)
+        alpha = int(std::max<int64_t>(int64_t(*previous_score) - aspiration_window, alpha));
+        beta = int(std::min<int64_t>(int64_t(*previous_score) + aspiration_window, beta));
+        if (alpha >= beta)
         {
-            minimax(result, depth, std::numeric_limits<int>::min(), result.initial_score, true);
+            alpha = std::numeric_limits<int>::min();
+            beta = result.initial_score;
+        }
+    }
+
+    while (!search_aborted)
+    {
+        minimax(result, search_depth, alpha, beta, true);
+
+        const bool failed_low = result.score <= alpha && alpha != std::numeric_limits<int>::min();
+        const bool failed_high = result.score >= beta && beta != result.initial_score;
+        if (search_aborted || (!failed_low && !failed_high))
+            break;
+
+        statistics.aspiration_researches++;
+        if (failed_low)
+            alpha = std::numeric_limits<int>::min();
+        else
+            beta = result.initial_score;
+        const int initial_score = result.initial_score;
+        result = MoveEvaluation();
+        result.initial_score = initial_score;
+    }
 #ifdef LOGGING
-            std::cout << "Score: " << result.score << std::endl;
-            std::cout << "Deepening score: " << deepened_move_score << std::endl;
+    std::cout << "Score: " << result.score << std::endl;
+#endif
+
+    while (result.score >= result.initial_score && !deepening_successful && !search_aborted)
+    {
+        deepening = true;
+        minimax(result, search_depth, std::numeric_limits<int>::min(), result.initial_score, true);
+#ifdef LOGGING
+        std::cout << "Score: " << result.score << std::endl;
+        std::cout << "Deepening score: " << deepened_move_score << std::endl;
 #endif
-            deepening = true;
-        }
     }
-    else
-        result.listMoves.push_back(MoveEvaluation{game.get_board_height() / 2, game.get_board_width() / 2});
-    return result;
+    if (!search_aborted)
+        statistics.completed_depth = search_depth;
+}
+
+/** Search one more ply at each iteration until a limit is reached.
+ * Moves of the previous iterations are tried first through the killer moves
+ * and the transposition table. The first iteration always completes so that
+ * there is a move to return.
+ */
+void GomokuAI::iterative_deepening(MoveEvaluation &result)
+{
+    search_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_budget_ms);
+
+    for (int iteration_depth = 1; iteration_depth <= depth; ++iteration_depth)
+    {
+        MoveEvaluation iteration;
+        std::optional<int> previous_score;
+        if (iteration_depth > 1)
+            previous_score = result.score;
+        search(iteration, iteration_depth, previous_score);
+
+        if (search_aborted)
+            break;
+
+        result = std::move(iteration);
+        search_can_abort = true;
+
+        if (result.listMoves.empty())
+            break;
+        const int best_score = getBestMoveEvaluation(result).score;
+        if (best_score == std::numeric_limits<int>::max() || best_score == std::numeric_limits<int>::min())
+            break;
+    }
+}
+
+bool GomokuAI::search_is_limited() const
+{
+    return time_budget_ms > 0 || node_limit > 0;
+}
+
+bool GomokuAI::search_limit_reached()
+{
+    if (search_aborted || !search_can_abort)
+        return search_aborted;
+
+    if (stop_signal && stop_signal->load(std::memory_order_relaxed))
+        search_aborted = true;
+    else if (node_limit > 0 && statistics.nodes >= node_limit)
+        search_aborted = true;
+    else if (time_budget_ms > 0 && (statistics.nodes & 0xff) == 0 && std::chrono::steady_clock::now() >= search_deadline)
+        search_aborted = true;
+
+    return search_aborted;
 }
 
-void GomokuAI::compute_relevant_moves(std::vector<MoveHeuristic> &out_relevant_moves, int _depth) const
+void GomokuAI::compute_relevant_moves(std::vector<MoveHeuristic> &out_relevant_moves, const std::pair<int, int> &first_move) const
 {
     TIMER
 
+    const CellSet &relevant_cells = game.get_relevant_cells();
     auto [min, max] = game.get_played_bounds(length);
-    out_relevant_moves.reserve((max.row - min.row + 1) * (max.col - min.col + 1));
+    out_relevant_moves.reserve(relevant_cells.size());
 
-    const auto &k_move = killer_moves[depth - _depth];
+    const auto &k_move = first_move;
     bool k_move_inserted = false;
-    if (game.get_cell_relevancy(k_move.first, k_move.second) > 0 && game.get_board_value(k_move.first, k_move.second) == E)
+    if (game.coordinates_are_valid(k_move.first, k_move.second) && relevant_cells.contains(k_move.first, k_move.second))
     {
         out_relevant_moves.emplace_back(MoveHeuristic{uint8_t(k_move.first), uint8_t(k_move.second), 0});
         k_move_inserted = true;
     }
 
-    if (!k_move_inserted)
-    {
-        for (int row = min.row; row <= max.row; ++row)
-        {
-            for (int col = min.col; col <= max.col; ++col)
-            {
-                if (game.get_cell_relevancy(row, col) <= 0 || game.get_board_value(row, col) != E)
-                    continue;
-
-                out_relevant_moves.emplace_back(MoveHeuristic{uint8_t(row), uint8_t(col), 0});
-            }
-        }
-    }
-    else
-    {
-        for (int row = min.row; row <= max.row; ++row)
+    relevant_cells.for_each(
+        [&](int row, int col)
         {
-            for (int col = min.col; col <= max.col; ++col)
-            {
-                if (game.get_cell_relevancy(row, col) <= 0 || game.get_board_value(row, col) != E)
-                    continue;
+            if (row < min.row || row > max.row || col < min.col || col > max.col)
+                return;
+            if (k_move_inserted && k_move == std::pair<int, int>(row, col))
+                return;
 
-                if (k_move != std::pair<int, int>(row, col))
-                {
-                    out_relevant_moves.emplace_back(MoveHeuristic{uint8_t(row), uint8_t(col), 0});
-                }
-            }
-        }
-    }
+            out_relevant_moves.emplace_back(MoveHeuristic{uint8_t(row), uint8_t(col), 0});
+        });
 }
 
 const GomokuAIData &GomokuAI::get_evaluation_data() const
@@ -351,6 +712,11 @@ const GomokuAIData &GomokuAI::get_evaluation_data() const
     return evaluation_data;
 }
 
+const SearchStatistics &GomokuAI::get_search_statistics() const
+{
+    return statistics;
+}
+
 std::pair<int, int> getBestMove(const MoveEvaluation &eval, bool maximizingPlayer)
 {
     if (eval.listMoves.empty())
@@ -0,0 +1,90 @@
+#include "ai/gomoku_ai_transposition_table.h"
+
+namespace AI
+{
+
+static size_t round_down_power_of_two(size_t size)
+{
+    size_t power = 1;
+    while (power <= size / 2)
+        power <<= 1;
+    return power;
+}
+
+TranspositionTable::TranspositionTable(size_t size)
+    : _size(round_down_power_of_two(size == 0 ? 1 : size)),
+      _mask(_size - 1)
+{
+    _slots = std::make_unique<Slot[]>(_size);
+    clear();
+}
+
+/*
+ * Unused(6) | Col(8) | Row(8) | Bound(2) | Depth(8) | Score(32)
+ * A null data word marks an empty slot, so the bound is stored plus one.
+ */
+
+uint64_t TranspositionTable::pack(const TranspositionEntry &entry)
+{
+    uint64_t data = 0;
+    data |= uint64_t(uint32_t(entry.score));
+    data |= uint64_t(uint8_t(entry.depth)) << 32;
+    data |= uint64_t(static_cast<uint8_t>(entry.bound) + 1) << 40;
+    data |= uint64_t(uint8_t(entry.row)) << 42;
+    data |= uint64_t(uint8_t(entry.col)) << 50;
+    return data;
+}
+
+TranspositionEntry TranspositionTable::unpack(uint64_t data)
+{
+    TranspositionEntry entry;
+    entry.score = int32_t(uint32_t(data));
+    entry.depth = int8_t(uint8_t(data >> 32));
+    entry.bound = TranspositionBound(((data >> 40) & 0b11) - 1);
+    entry.row = int8_t(uint8_t(data >> 42));
+    entry.col = int8_t(uint8_t(data >> 50));
+    return entry;
+}
+
+bool TranspositionTable::probe(uint64_t key, TranspositionEntry &out_entry) const
+{
+    const Slot &slot = _slots[key & _mask];
+    const uint64_t data = slot.data.load(std::memory_order_relaxed);
+    const uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    if (data == 0 || (check ^ data) != key)
+        return false;
+
+    out_entry = unpack(data);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, const TranspositionEntry &entry)
+{
+    Slot &slot = _slots[key & _mask];
+    const uint64_t data = slot.data.load(std::memory_order_relaxed);
+    const uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    if (data != 0 && (check ^ data) == key && unpack(data).depth > entry.depth)
+        return;
+
+    const uint64_t new_data = pack(entry);
+    slot.check.store(key ^ new_data, std::memory_order_relaxed);
+    slot.data.store(new_data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < _size; ++i)
+    {
+        _slots[i].check.store(0, std::memory_order_relaxed);
+        _slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t TranspositionTable::size() const
+{
+    return _size;
+}
+
+} // namespace AI
@@ -15,7 +15,7 @@ std::vector<std::string> structure_names = {
     "FOUR",
     "COUNT_STRUCTURE_TYPE"};
 
-std::vector<std::string> player_names = {".", "X", "O"};
+std::vector<std::string> player_names = {".", "X", "O", "#"};
 
 std::ostream &operator<<(std::ostream &stream, Player player)
 {
@@ -29,6 +29,18 @@ std::ostream &operator<<(std::ostream &stream, StructureType structure_type)
     return stream;
 }
 
+std::vector<std::string> move_status_names = {
+    "SUCCESS",
+    "INVALID_COORDINATES",
+    "OCCUPIED_CELL",
+    "DOUBLE_THREE"};
+
+std::ostream &operator<<(std::ostream &stream, MoveStatus status)
+{
+    stream << move_status_names[static_cast<int>(status)];
+    return stream;
+}
+
 static int score_from_structure(StructureType type)
 {
     switch (type)
@@ -63,70 +75,106 @@ bool compare_structure_type(StructureType lhs, StructureType rhs)
     return score_from_structure(lhs) < score_from_structure(rhs);
 }
 
+/** Zobrist keys.
+ * Keys are derived from their feature with splitmix64 instead of being read
+ * from a random table, so they don't depend on the board size. The keys of
+ * an empty cell and of a null score are 0, which makes the hash of an empty
+ * board with black to play 0.
+ */
+static inline uint64_t zobrist_mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static inline uint64_t zobrist_cell_key(int row, int col, Player player)
+{
+    if (player == E)
+        return 0;
+    return zobrist_mix((uint64_t(player) << 16) | (uint64_t(uint8_t(row)) << 8) | uint64_t(uint8_t(col)));
+}
+
+static inline uint64_t zobrist_score_key(Player player, int score)
+{
+    if (score == 0)
+        return 0;
+    return zobrist_mix((uint64_t(1) << 32) | (uint64_t(player) << 16) | uint64_t(uint16_t(score)));
+}
+
+static const uint64_t zobrist_side_key = zobrist_mix(uint64_t(1) << 40);
+
+typedef GomokuGameTraits<GOMOKU_STANDARD_BOARD_SIZE, GOMOKU_STANDARD_BOARD_SIZE, CaptureRules> StandardCaptureTraits;
+typedef GomokuGameTraits<GOMOKU_STANDARD_BOARD_SIZE, GOMOKU_STANDARD_BOARD_SIZE, NoCaptureRules> StandardNoCaptureTraits;
+typedef GomokuGameTraits<0, 0, CaptureRules> AnySizeCaptureTraits;
+typedef GomokuGameTraits<0, 0, NoCaptureRules> AnySizeNoCaptureTraits;
+
+template <typename Function>
+decltype(auto) GomokuGame::with_traits(Function &&function)
+{
+    switch (_specialisation)
+    {
+    case STANDARD_CAPTURE:
+        return function(StandardCaptureTraits());
+    case STANDARD_NO_CAPTURE:
+        return function(StandardNoCaptureTraits());
+    case ANY_SIZE_CAPTURE:
+        return function(AnySizeCaptureTraits());
+    default:
+        return function(AnySizeNoCaptureTraits());
+    }
+}
+
+template <typename Traits>
+bool GomokuGame::coordinates_are_valid_as(int row, int col) const
+{
+    if constexpr (Traits::fixed_size)
+        return unsigned(row) < unsigned(Traits::height) && unsigned(col) < unsigned(Traits::width);
+    else
+        return coordinates_are_valid(row, col);
+}
+
 // Definitions of GomokuGame methods
 GomokuGame::GomokuGame(uint width, uint height, bool capture_enabled)
-    : board(width, height),
+    : board(width, height, OUTSIDE),
+      _bitboard(width, height),
       _min_played(width, height),
       _max_played(0, 0),
-      _relevancy_matrix(width + 4, height + 4),
-      _relevant_cells({}),
+      _relevancy_matrix(width, height),
+      _relevant_cells(width, height),
       empty_cells(width * height),
       current_player(X),
       players_scores({0, 0, 0}),
       is_game_over_flag(false),
       winner(E),
       players_reconizers({
-          GomokuPatternReconizer(E),
           GomokuPatternReconizer(X),
           GomokuPatternReconizer(O),
       }),
-      _capture_enabled(capture_enabled)
+      _capture_enabled(capture_enabled),
+      _hash(0)
 {
-    players_reconizers[X].find_patterns_in_board(*this);
-    players_reconizers[O].find_patterns_in_board(*this);
-}
+    const bool standard_size = width == GOMOKU_STANDARD_BOARD_SIZE && height == GOMOKU_STANDARD_BOARD_SIZE;
+    if (standard_size)
+        _specialisation = capture_enabled ? STANDARD_CAPTURE : STANDARD_NO_CAPTURE;
+    else
+        _specialisation = capture_enabled ? ANY_SIZE_CAPTURE : ANY_SIZE_NO_CAPTURE;
 
-GomokuGame::GomokuGame(const GomokuGame &copy)
-    : board(copy.board),
-      _min_played(copy._min_played),
-      _max_played(copy._max_played),
-      _relevancy_matrix(copy._relevancy_matrix),
-      _relevant_cells(copy._relevant_cells),
-      empty_cells(copy.empty_cells),
-      current_player(copy.current_player),
-      players_scores(copy.players_scores),
-      is_game_over_flag(copy.is_game_over_flag),
-      winner(copy.winner),
-      players_reconizers(copy.players_reconizers),
-      _capture_enabled(copy._capture_enabled)
-{
+    reconizer_of(X).find_patterns_in_board(*this);
+    reconizer_of(O).find_patterns_in_board(*this);
 }
 
-GomokuGame &GomokuGame::operator=(const GomokuGame &copy)
+CellChange GomokuGame::set_board_value(int row, int col, Player value, bool updateRelevancyMatrix)
 {
-    if (this != &copy)
-    {
-        board = copy.board;
-        _min_played = copy._min_played;
-        _max_played = copy._max_played;
-        _relevancy_matrix = copy._relevancy_matrix;
-        _relevant_cells = copy._relevant_cells;
-        empty_cells = copy.empty_cells;
-        current_player = copy.current_player;
-        players_scores = copy.players_scores;
-        is_game_over_flag = copy.is_game_over_flag;
-        winner = copy.winner;
-        players_reconizers = copy.players_reconizers;
-        _capture_enabled = copy._capture_enabled;
-    }
-    return *this;
+    return with_traits([&](auto traits)
+                       { return set_board_value_as<decltype(traits)>(row, col, value, updateRelevancyMatrix); });
 }
 
-GomokuGame::~GomokuGame() {}
-
-CellChange GomokuGame::set_board_value(int row, int col, Player value, bool updateRelevancyMatrix)
+template <typename Traits>
+CellChange GomokuGame::set_board_value_as(int row, int col, Player value, bool updateRelevancyMatrix)
 {
-    assert(coordinates_are_valid(row, col));
+    assert(coordinates_are_valid_as<Traits>(row, col));
     assert(board(row, col) != value);
 
     CellChange cell_change;
@@ -137,6 +185,11 @@ CellChange GomokuGame::set_board_value(int row, int col, Player value, bool upda
     cell_change.old_value = board(row, col);
     board(row, col) = value;
     cell_change.new_value = value;
+    _bitboard.set(row, col, cell_change.old_value, value);
+    if (_move_gains.is_enabled())
+        _move_gains.update(_bitboard, row, col);
+
+    _hash ^= zobrist_cell_key(row, col, cell_change.old_value) ^ zobrist_cell_key(row, col, value);
 
     // Assume that if the value is E, then the cell was occupied before because there is no situation in which you would empty an empty cell
     // and if the value is not E, then the cell was not occupied because you cannot turn a stone into another stone in Gomoku.
@@ -144,6 +197,11 @@ CellChange GomokuGame::set_board_value(int row, int col, Player value, bool upda
     if (updateRelevancyMatrix) 
         update_relevancy(row, col, value == E);
 
+    if (value != E)
+        _relevant_cells.erase(row, col);
+    else if (get_cell_relevancy(row, col) > 0)
+        _relevant_cells.insert(row, col);
+
     return cell_change;
 }
 
@@ -154,7 +212,16 @@ Player GomokuGame::other_player(Player player) const
 
 void GomokuGame::modify_player_score(Player player, int score)
 {
+    _hash ^= zobrist_score_key(player, players_scores[player]);
     players_scores[player] += score;
+    _hash ^= zobrist_score_key(player, players_scores[player]);
+}
+
+void GomokuGame::set_current_player(Player player)
+{
+    if (player != current_player)
+        _hash ^= zobrist_side_key;
+    current_player = player;
 }
 
 std::pair<GomokuCellIndex, GomokuCellIndex> GomokuGame::get_played_bounds(int margin) const
@@ -186,19 +253,19 @@ const CellSet &GomokuGame::get_relevant_cells() const
 
 const GomokuPatternReconizer &GomokuGame::get_pattern_reconizer(Player player) const
 {
-    return players_reconizers[player];
+    return reconizer_of(player);
 }
 
-const std::vector<int> &GomokuGame::get_patterns_count(Player player)
+const StructureCounts &GomokuGame::get_patterns_count(Player player)
 {
     TIMER
-    return players_reconizers[player].get_pattern_count();
+    return reconizer_of(player).get_pattern_count();
 }
 
 void GomokuGame::print_patterns()
 {
-    players_reconizers[X].print_patterns();
-    players_reconizers[O].print_patterns();
+    reconizer_of(X).print_patterns();
+    reconizer_of(O).print_patterns();
 }
 
 std::vector<std::vector<int>> GomokuGame::get_board() const
@@ -228,59 +295,91 @@ bool GomokuGame::coordinates_are_valid(int row, int col) const
 
 bool GomokuGame::pattern_coordinate_is_valid(const PatternCellIndex &index) const
 {
-    return coordinates_are_valid(index.row - 1, index.col - 1);
+    return coordinates_are_valid(index.row, index.col);
 }
 
 MoveResult GomokuGame::make_move(int row, int col, bool updateRelevancyMatrix)
 {
-    TIMER
     MoveResult move_result;
+
+    switch (try_make_move(row, col, move_result, updateRelevancyMatrix))
+    {
+    case MoveStatus::SUCCESS:
+        break;
+    case MoveStatus::INVALID_COORDINATES:
+        throw std::invalid_argument("Invalid coordinates " + std::to_string(row) + ", " + std::to_string(col));
+    case MoveStatus::OCCUPIED_CELL:
+        throw std::invalid_argument("Cell is already occupied");
+    case MoveStatus::DOUBLE_THREE:
+        throw std::invalid_argument("Invalid move: more than one open three");
+    }
+
+    return move_result;
+}
+
+MoveStatus GomokuGame::try_make_move(int row, int col, MoveResult &move_result, bool updateRelevancyMatrix)
+{
+    return with_traits([&](auto traits)
+                       { return try_make_move_as<decltype(traits)>(row, col, move_result, updateRelevancyMatrix); });
+}
+
+template <typename Traits>
+MoveStatus GomokuGame::try_make_move_as(int row, int col, MoveResult &move_result, bool updateRelevancyMatrix)
+{
+    TIMER
+    if (!coordinates_are_valid_as<Traits>(row, col))
+        return MoveStatus::INVALID_COORDINATES;
+    if (get_board_value(row, col) != E)
+        return MoveStatus::OCCUPIED_CELL;
+
+    move_result.cell_changes.clear();
     move_result.previous_min_move = _min_played;
     move_result.previous_max_move = _max_played;
 
     const int old_black_score = get_player_score(X);
     const int old_white_score = get_player_score(O);
 
-    const int old_open_three_count = players_reconizers[current_player].get_pattern_count()[StructureType::OPEN_THREE];
+    /** Counts before the move, turned into the delta of the move once the patterns are updated */
+    PatternCountDelta &delta = move_result.pattern_count_delta;
+    for (Player player : {X, O})
+        std::copy_n(reconizer_of(player).get_pattern_count().begin(), StructureType::COUNT_STRUCTURE_TYPE, delta.of(player));
 
-    if (!coordinates_are_valid(row, col))
-    {
-        throw std::invalid_argument("Invalid coordinates " + std::to_string(row) + ", " + std::to_string(col));
-    }
-    if (get_board_value(row, col) != E)
-    {
-        throw std::invalid_argument("Cell is already occupied");
-    }
-
-    const CellChange cell_change = set_board_value(row, col, current_player, updateRelevancyMatrix);
+    const CellChange cell_change = set_board_value_as<Traits>(row, col, current_player, updateRelevancyMatrix);
     move_result.cell_changes.push_back(cell_change);
 
     bool captured = false;
 
-    if (_capture_enabled)
-        captured = capture(row, col, current_player, move_result, updateRelevancyMatrix);
+    if constexpr (Traits::capture_enabled)
+        captured = capture<Traits>(row, col, current_player, move_result, updateRelevancyMatrix);
 
     move_result.black_score_change = get_player_score(X) - old_black_score;
     move_result.white_score_change = get_player_score(O) - old_white_score;
 
-    players_reconizers[X].update_patterns_with_move(*this, move_result);
-    players_reconizers[O].update_patterns_with_move(*this, move_result);
+    GomokuPatternReconizer::update_patterns_with_move(reconizer_of(X), reconizer_of(O), *this, move_result);
 
+    for (Player player : {X, O})
+    {
+        const StructureCounts &counts = reconizer_of(player).get_pattern_count();
+        for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; ++i)
+            delta.of(player)[i] = counts[i] - delta.of(player)[i];
+    }
+
+    /** Checked after the update as it's free for legal moves, where
+     * is_double_three would walk the patterns for every move */
     if (!captured)
     {
-        const int new_open_three_count = players_reconizers[current_player].get_pattern_count()[StructureType::OPEN_THREE];
-        if (new_open_three_count - old_open_three_count > 1)
+        if (delta.of(current_player)[StructureType::OPEN_THREE] > 1)
         {
             Player p = current_player;
-            reverse_move(move_result, updateRelevancyMatrix);
-            current_player = p;
-            throw std::invalid_argument("Invalid move: more than one open three");
+            reverse_move_as<Traits>(move_result, updateRelevancyMatrix);
+            set_current_player(p);
+            return MoveStatus::DOUBLE_THREE;
         }
     }
 
-    check_win(current_player);
+    check_win_as<Traits>(current_player);
 
-    current_player = other_player(current_player);
+    set_current_player(other_player(current_player));
 
     if (row < _min_played.row)
         _min_played.row = row;
@@ -291,24 +390,32 @@ MoveResult GomokuGame::make_move(int row, int col, bool updateRelevancyMatrix)
     if (col > _max_played.col)
         _max_played.col = col;
 
-    return move_result;
+    return MoveStatus::SUCCESS;
 }
 
 void GomokuGame::reverse_move(const MoveResult &move, bool updateRelevancyMatrix)
+{
+    with_traits([&](auto traits)
+                { reverse_move_as<decltype(traits)>(move, updateRelevancyMatrix); });
+}
+
+template <typename Traits>
+void GomokuGame::reverse_move_as(const MoveResult &move, bool updateRelevancyMatrix)
 {
     TIMER
     modify_player_score(X, -move.black_score_change);
     modify_player_score(O, -move.white_score_change);
 
-    current_player = other_player(current_player);
+    set_current_player(other_player(current_player));
 
     for (const CellChange &cell_change : move.cell_changes)
     {
-        set_board_value(cell_change.row, cell_change.col, cell_change.old_value, updateRelevancyMatrix);
+        set_board_value_as<Traits>(cell_change.row, cell_change.col, cell_change.old_value, updateRelevancyMatrix);
     }
 
-    players_reconizers[X].update_patterns_with_move(*this, move);
-    players_reconizers[O].update_patterns_with_move(*this, move);
+    /** Moves made before journaling was turned on, or that didn't fit in the journal, are recomputed */
+    if (reconizer_of(X).journaled_moves() == 0 || !GomokuPatternReconizer::undo_patterns_with_move(reconizer_of(X), reconizer_of(O)))
+        GomokuPatternReconizer::update_patterns_with_move(reconizer_of(X), reconizer_of(O), *this, move, false);
 
     winner = E;
     is_game_over_flag = false;
@@ -317,22 +424,39 @@ void GomokuGame::reverse_move(const MoveResult &move, bool updateRelevancyMatrix
     _max_played = move.previous_max_move;
 }
 
+void GomokuGame::set_pattern_journaling(bool enabled)
+{
+    reconizer_of(X).set_journaling(enabled);
+    reconizer_of(O).set_journaling(enabled);
+}
+
+void GomokuGame::set_move_gains_enabled(bool enabled)
+{
+    _move_gains.set_enabled(enabled, _bitboard, get_board_width(), get_board_height());
+}
+
 void GomokuGame::reapply_move(const MoveResult &move)
+{
+    with_traits([&](auto traits)
+                { reapply_move_as<decltype(traits)>(move); });
+}
+
+template <typename Traits>
+void GomokuGame::reapply_move_as(const MoveResult &move)
 {
     modify_player_score(X, move.black_score_change);
     modify_player_score(O, move.white_score_change);
 
     for (const CellChange &cell_change : move.cell_changes)
     {
-        set_board_value(cell_change.row, cell_change.col, cell_change.new_value);
+        set_board_value_as<Traits>(cell_change.row, cell_change.col, cell_change.new_value, true);
     }
 
-    players_reconizers[X].update_patterns_with_move(*this, move);
-    players_reconizers[O].update_patterns_with_move(*this, move);
+    GomokuPatternReconizer::update_patterns_with_move(reconizer_of(X), reconizer_of(O), *this, move);
 
-    check_win(current_player);
+    check_win_as<Traits>(current_player);
 
-    current_player = other_player(current_player);
+    set_current_player(other_player(current_player));
 
     const int8_t &row = move.cell_changes[0].row;
     const int8_t &col = move.cell_changes[0].col;
@@ -347,80 +471,87 @@ void GomokuGame::reapply_move(const MoveResult &move)
         _max_played.col = col;
 }
 
-static const std::vector<std::pair<int, int>> _directions_offsets = {
+/** Arrays of constants so the loops over them unroll */
+static constexpr std::pair<int, int> _directions_offsets[] = {
     {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
 
+/** Order in which captured stones are recorded in the MoveResult */
+static constexpr std::pair<int, int> _capture_directions[] = {
+    {1, 0}, {1, 1}, {-1, 0}, {-1, -1}, {0, 1}, {-1, 1}, {0, -1}, {1, -1}};
+
 void GomokuGame::update_relevancy(int8_t row, int8_t col, bool is_new_empty_cell)
 {
     int8_t modify = is_new_empty_cell ? -1 : 1;
-    int baseRow = row + 2;
-    int baseCol = col + 2;
+    const int base = GomokuRelevancyMatrix::offset_of(row, col);
     for (const auto &dir : _directions_offsets)
     {
-        int dirFirst = dir.first;
-        int dirSecond = dir.second;
-        for (int step = 1; step <= 2; ++step)
+        const int dir_offset = GomokuRelevancyMatrix::offset_of_direction(dir.first, dir.second);
+        for (int step = 1; step <= RELEVANCY_LENGTH; ++step)
         {
-            int newRow = baseRow + step * dirFirst;
-            int newCol = baseCol + step * dirSecond;
-
-            _relevancy_matrix(newRow, newCol) += modify;
+            const int offset = base + step * dir_offset;
+
+            int8_t &relevancy = _relevancy_matrix.at(offset);
+            relevancy += modify;
+
+            /** Only a cell going from or to 0 enters or leaves the candidates, the border is never empty */
+            if (relevancy == (is_new_empty_cell ? 0 : 1) && board.at(offset) == E)
+            {
+                if (is_new_empty_cell)
+                    _relevant_cells.erase(row + step * dir.first, col + step * dir.second);
+                else
+                    _relevant_cells.insert(row + step * dir.first, col + step * dir.second);
+            }
         }
     }
 }
 
+template <typename Traits>
 bool GomokuGame::try_direction_for_capture(int row, int col, int row_dir, int col_dir, Player player, MoveResult &move_result, bool updateRelevancyMatrix)
 {
-    const Player otherPlayer = other_player(player);
-
-    const int x1 = row + row_dir;
-    const int y1 = col + col_dir;
-    const int x2 = row + 2 * row_dir;
-    const int y2 = col + 2 * col_dir;
-    const int x3 = row + 3 * row_dir;
-    const int y3 = col + 3 * col_dir;
-
-    if (get_board_value(x1, y1) != otherPlayer || get_board_value(x2, y2) != otherPlayer || get_board_value(x3, y3) != player)
+    if (!_bitboard.captures(row, col, row_dir, col_dir, player))
         return false;
 
     move_result.cell_changes.push_back(
-        set_board_value(row + row_dir, col + col_dir, E, updateRelevancyMatrix));
+        set_board_value_as<Traits>(row + row_dir, col + col_dir, E, updateRelevancyMatrix));
 
     move_result.cell_changes.push_back(
-        set_board_value(row + 2 * row_dir, col + 2 * col_dir, E, updateRelevancyMatrix));
+        set_board_value_as<Traits>(row + 2 * row_dir, col + 2 * col_dir, E, updateRelevancyMatrix));
 
     modify_player_score(player, 2);
     return true;
 }
 
+template <typename Traits>
 bool GomokuGame::capture(int row, int col, Player player, MoveResult &move_result, bool updateRelevancyMatrix)
 {
     bool ret = false;
-    if (row < board.get_height() - 3)
-    {
-        ret |= try_direction_for_capture(row, col, 1, 0, player, move_result, updateRelevancyMatrix);
-        if (col < board.get_width() - 3)
-            ret |= try_direction_for_capture(row, col, 1, 1, player, move_result, updateRelevancyMatrix);
-    }
-    if (row > 2)
-    {
-        ret |= try_direction_for_capture(row, col, -1, 0, player, move_result, updateRelevancyMatrix);
-        if (col > 2)
-            ret |= try_direction_for_capture(row, col, -1, -1, player, move_result, updateRelevancyMatrix);
-    }
-    if (col < board.get_width() - 3)
-    {
-        ret |= try_direction_for_capture(row, col, 0, 1, player, move_result, updateRelevancyMatrix);
-        if (row > 2)
-            ret |= try_direction_for_capture(row, col, -1, 1, player, move_result, updateRelevancyMatrix);
-    }
-    if (col > 2)
+    for (const auto &[row_dir, col_dir] : _capture_directions)
+        ret |= try_direction_for_capture<Traits>(row, col, row_dir, col_dir, player, move_result, updateRelevancyMatrix);
+    return ret;
+}
+
+bool GomokuGame::can_capture(int row, int col, Player player) const
+{
+    for (const auto &[row_dir, col_dir] : _capture_directions)
     {
-        ret |= try_direction_for_capture(row, col, 0, -1, player, move_result, updateRelevancyMatrix);
-        if (row < board.get_height() - 3)
-            ret |= try_direction_for_capture(row, col, 1, -1, player, move_result, updateRelevancyMatrix);
+        if (_bitboard.captures(row, col, row_dir, col_dir, player))
+            return true;
     }
-    return ret;
+    return false;
+}
+
+bool GomokuGame::is_double_three(int row, int col, Player player) const
+{
+    TIMER
+    if (!coordinates_are_valid(row, col) || get_board_value(row, col) != E)
+        return false;
+
+    /** A capture makes any double three legal */
+    if (_capture_enabled && can_capture(row, col, player))
+        return false;
+
+    const PatternCellIndex index(GomokuCellIndex(row, col));
+    return reconizer_of(player).structure_count_delta_with_stone(*this, index, StructureType::OPEN_THREE) > 1;
 }
 
 int GomokuGame::get_board_width() const
@@ -434,6 +565,13 @@ int GomokuGame::get_board_height() const
 }
 
 void GomokuGame::check_win(Player player)
+{
+    with_traits([&](auto traits)
+                { check_win_as<decltype(traits)>(player); });
+}
+
+template <typename Traits>
+void GomokuGame::check_win_as(Player player)
 {
     if (get_player_score(player) >= 10)
     {
@@ -442,10 +580,10 @@ void GomokuGame::check_win(Player player)
         return;
     }
 
-    if (players_reconizers[player].get_pattern_count()
+    if (reconizer_of(player).get_pattern_count()
             [StructureType::FIVE_OR_MORE] > 0)
     {
-        if (not _capture_enabled || players_reconizers[player].five_or_more_cant_be_captured(*this))
+        if (not Traits::capture_enabled || _bitboard.find_uncapturable_five(player))
         {
             is_game_over_flag = true;
             winner = current_player;
@@ -453,9 +591,9 @@ void GomokuGame::check_win(Player player)
         }
     }
 
-    if (get_player_score(other_player(player)) == 8)
+    if (Traits::capture_enabled && get_player_score(other_player(player)) == 8)
     {
-        if (players_reconizers[player].can_be_captured(*this))
+        if (_bitboard.has_capturable_stones(player))
         {
             is_game_over_flag = true;
             winner = other_player(player);
@@ -484,10 +622,17 @@ int GomokuGame::get_player_score(Player player) const
     return players_scores[player];
 }
 
-bool cell_set_contains(const CellSet &cell_set, int row, int col)
+uint64_t GomokuGame::get_hash() const
 {
-    auto row_it = cell_set.find(row);
-    if (row_it == cell_set.end())
-        return false;
-    return row_it->second.find(col) != row_it->second.end();
+    return _hash;
+}
+
+const GomokuBitboard &GomokuGame::get_bitboard() const
+{
+    return _bitboard;
+}
+
+const GomokuMoveGains &GomokuGame::get_move_gains() const
+{
+    return _move_gains;
 }
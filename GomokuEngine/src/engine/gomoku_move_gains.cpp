@@ -0,0 +1,100 @@
+#include "engine/gomoku_move_gains.h"
+#include <algorithm>
+
+/** Steps of each direction, matching PatternDirection */
+static constexpr int direction_steps[PatternDirection::Count_PatternDirection][2] = {
+    {0, 1},
+    {1, 0},
+    {1, 1},
+    {1, -1},
+};
+
+GomokuMoveGains::GomokuMoveGains()
+    : _enabled(false), _width(0), _height(0)
+{
+}
+
+void GomokuMoveGains::set_enabled(bool enabled, const GomokuBitboard &bitboard, int width, int height)
+{
+    _enabled = enabled;
+    _width = width;
+    _height = height;
+
+    for (CellGains *cells : _cells)
+        std::fill_n(cells, width * height, CellGains{{StructureType::NONE, StructureType::NONE, StructureType::NONE, StructureType::NONE}, 0});
+
+    if (!enabled)
+        return;
+
+    for (int row = 0; row < height; ++row)
+        for (int col = 0; col < width; ++col)
+            for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
+                update_cell(bitboard, row, col, PatternDirection(direction));
+}
+
+void GomokuMoveGains::update(const GomokuBitboard &bitboard, int row, int col)
+{
+    const int radius = GomokuWindowReconizer::window_radius;
+    WindowPattern patterns[2][GomokuWindowReconizer::window_size];
+
+    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
+    {
+        const int row_step = direction_steps[direction][0];
+        const int col_step = direction_steps[direction][1];
+
+        GomokuWindowReconizer::patterns_around(bitboard, row, col, PatternDirection(direction), patterns[0], patterns[1]);
+
+        for (int distance = -radius; distance <= radius; ++distance)
+        {
+            const int cell_row = row + distance * row_step;
+            const int cell_col = col + distance * col_step;
+
+            if (cell_row >= 0 && cell_row < _height && cell_col >= 0 && cell_col < _width)
+            {
+                set_gain(X, cell_row, cell_col, PatternDirection(direction), patterns[0][distance + radius].gain);
+                set_gain(O, cell_row, cell_col, PatternDirection(direction), patterns[1][distance + radius].gain);
+            }
+        }
+    }
+}
+
+int GomokuMoveGains::threat_weight(StructureType structure)
+{
+    switch (structure)
+    {
+    case ONE:
+        return 1;
+    case OPEN_ONE:
+        return 2;
+    case TWO:
+        return 4;
+    case OPEN_TWO:
+        return 10;
+    case THREE:
+        return 20;
+    case OPEN_THREE:
+        return 100;
+    case FOUR:
+        return 120;
+    case OPEN_FOUR:
+        return 1000;
+    case FIVE_OR_MORE:
+        return 10000;
+    default:
+        return 0;
+    }
+}
+
+void GomokuMoveGains::update_cell(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction)
+{
+    for (Player player : {X, O})
+        set_gain(player, row, col, direction, GomokuWindowReconizer(player).gain_at(bitboard, row, col, direction));
+}
+
+void GomokuMoveGains::set_gain(Player player, int row, int col, PatternDirection direction, StructureType gain)
+{
+    CellGains &cell_gains = _cells[player - 1][row * _width + col];
+
+    cell_gains.threat += threat_weight(gain) - threat_weight(cell_gains.directions[direction]);
+    cell_gains.directions[direction] = gain;
+}
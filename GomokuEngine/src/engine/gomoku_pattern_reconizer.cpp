@@ -1,8 +1,10 @@
 
 #include "engine/gomoku_pattern_reconizer.h"
 #include "engine/gomoku_engine.h"
-#include <unordered_set>
+#include <array>
 #include <cassert>
+#include <stdexcept>
+#include <string>
 
 /** PatternCellState */
 
@@ -25,90 +27,6 @@ std::ostream &operator<<(std::ostream &stream, PatternCellState cell_state)
 
 /** PatternCellData */
 
-PatternCellData::PatternCellData(uint16_t data) : _data(data)
-{
-    assert((_data & 0b1100000000000000) == 0);
-}
-
-PatternCellData::PatternCellData(uint8_t sequence_length,
-                                 bool is_sequence_closed,
-                                 uint8_t structure_length,
-                                 bool is_structure_closed,
-                                 uint8_t previous_structure_length,
-                                 bool is_previous_structure_closed,
-                                 bool is_gap_open_three,
-                                 bool is_gap_open_three_closed)
-    : _data(0)
-{
-    _data |= std::min(sequence_length, uint8_t(15));
-    _data |= is_sequence_closed ? 0b10000 : 0;
-    _data |= std::min(structure_length, uint8_t(7)) << 5;
-    _data |= is_structure_closed ? 0b100000000 : 0;
-    _data |= std::min(previous_structure_length, uint8_t(3)) << 9;
-    _data |= is_previous_structure_closed ? 0b100000000000 : 0;
-    _data |= is_gap_open_three ? 0b1000000000000 : 0;
-    _data |= is_gap_open_three_closed ? 0b10000000000000 : 0;
-
-    assert((_data & 0b1100000000000000) == 0);
-}
-
-/*
- * IsClosGop(1) | IsGop(1) | PrevStructClos(1) | PrevStructLen(2) | StructClos(1) | StructLen(3) | SeqClos(1) | SeqLen(4)
- * 0              0          0                   00                 0               000            0            0000
- *  0  0  0 00 0 000 0 0000
- * 13 12 11  9 8   5 4    0
- */
-
-uint8_t PatternCellData::sequence_length() const
-{
-    return _data & 0b1111;
-}
-
-bool PatternCellData::is_sequence_closed() const
-{
-    return (_data & 0b10000) != 0;
-}
-
-uint8_t PatternCellData::structure_length() const
-{
-    return (_data & 0b11100000) >> 5;
-}
-
-bool PatternCellData::is_structure_closed() const
-{
-    return (_data & 0b100000000) != 0;
-}
-
-uint8_t PatternCellData::previous_structure_length() const
-{
-    return (_data & 0b11000000000) >> 9;
-}
-
-bool PatternCellData::is_previous_structure_closed() const
-{
-    return (_data & 0b100000000000) != 0;
-}
-
-bool PatternCellData::is_gap_open_three() const
-{
-    return (_data & 0b1000000000000) != 0;
-}
-
-bool PatternCellData::is_gap_open_three_closed() const
-{
-    return (_data & 0b10000000000000) != 0;
-}
-
-bool PatternCellData::operator!=(const PatternCellData &comp) const
-{
-    return _data != comp._data;
-}
-
-PatternCellData PatternCellData::pre_bound_element()
-{
-    return PatternCellData(0, true, 0, false, 0, false, false, false);
-}
-
 bool PatternCellData::contains_structure() const
 {
     return structure_length() > 0 || is_gap_open_three();
@@ -135,6 +53,11 @@ StructureType PatternCellData::get_relevant_structure() const
 }
 
 void PatternCellData::get_structures_type_count(std::vector<int> &array, int factor) const
+{
+    get_structures_type_count(array.data(), factor);
+}
+
+void PatternCellData::get_structures_type_count(int *array, int factor) const
 {
     if (structure_length() > 0 && structure_length() < 5)
     {
@@ -194,11 +117,6 @@ void PatternCellData::get_structures_type_count(std::vector<int> &array, int fac
     }
 }
 
-uint16_t PatternCellData::data() const
-{
-    return _data;
-}
-
 std::ostream &operator<<(std::ostream &stream, const PatternCellData &c)
 {
     stream << "[" << static_cast<int>(c.sequence_length())
@@ -224,7 +142,7 @@ PatternCellIndex::PatternCellIndex(int row, int col) : Matrix<PatternCellData>::
 {
 }
 
-PatternCellIndex::PatternCellIndex(GomokuCellIndex gomoku_index) : Matrix<PatternCellData>::Index(gomoku_index.row + 1, gomoku_index.col + 1)
+PatternCellIndex::PatternCellIndex(GomokuCellIndex gomoku_index) : Matrix<PatternCellData>::Index(gomoku_index.row, gomoku_index.col)
 {
 }
 
@@ -252,40 +170,67 @@ std::ostream &operator<<(std::ostream &stream, PatternDirection direction)
     return stream;
 }
 
-/** GomokuPatternReconizer */
+/** PatternCellMatrix */
 
-GomokuPatternReconizer::GomokuPatternReconizer(Player player)
-    : _gomoku_player(player),
-      _cell_matrices(static_cast<int>(PatternDirection::Count_PatternDirection)),
-      _structure_maps(static_cast<int>(PatternDirection::Count_PatternDirection)),
-      _cached_pattern_count(static_cast<int>(StructureType::COUNT_STRUCTURE_TYPE), 0),
-      _tagging_mode(false)
+/** Number the cells line by line: a line starts on each cell whose previous cell in the direction is outside */
+static constexpr PatternCellMatrix::LineOffsets make_line_offsets()
 {
+    constexpr int size = PatternCellMatrix::padded_size;
+    constexpr int steps[PatternDirection::Count_PatternDirection][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+
+    PatternCellMatrix::LineOffsets line_offsets{};
+    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
+    {
+        const int row_step = steps[direction][0];
+        const int col_step = steps[direction][1];
+        int offset = 0;
+        for (int row = 0; row < size; ++row)
+        {
+            for (int col = 0; col < size; ++col)
+            {
+                const int previous_row = row - row_step;
+                const int previous_col = col - col_step;
+                if (previous_row >= 0 && previous_col >= 0 && previous_col < size)
+                    continue;
+
+                for (int r = row, c = col; r < size && c >= 0 && c < size; r += row_step, c += col_step)
+                    line_offsets.offsets[direction][r][c] = offset++;
+            }
+        }
+    }
+    return line_offsets;
 }
 
-GomokuPatternReconizer::GomokuPatternReconizer(const GomokuPatternReconizer &copy)
-    : _gomoku_player(copy._gomoku_player),
-      _cell_matrices(copy._cell_matrices),
-      _structure_maps(copy._structure_maps),
-      _cached_pattern_count(copy._cached_pattern_count),
-      _tagging_mode(copy._tagging_mode)
+const PatternCellMatrix::LineOffsets PatternCellMatrix::_line_offsets = make_line_offsets();
+
+PatternCellMatrix::PatternCellMatrix(PatternDirection direction, int width, int height)
+    : _direction(direction), _width(width), _height(height)
 {
+    if (width < 0 || height < 0 || width > GOMOKU_MAX_BOARD_SIZE || height > GOMOKU_MAX_BOARD_SIZE)
+        throw std::invalid_argument("Pattern matrices are limited to " + std::to_string(GOMOKU_MAX_BOARD_SIZE) + "x" + std::to_string(GOMOKU_MAX_BOARD_SIZE));
 }
 
-GomokuPatternReconizer &GomokuPatternReconizer::operator=(const GomokuPatternReconizer &copy)
+void PatternCellMatrix::fill_border(const PatternCellData &sentinel)
 {
-    if (this != &copy)
+    for (int row = -1; row <= _height; ++row)
     {
-        _gomoku_player = copy._gomoku_player;
-        _cell_matrices = copy._cell_matrices;
-        _structure_maps = copy._structure_maps;
-        _cached_pattern_count = copy._cached_pattern_count;
-        _tagging_mode = copy._tagging_mode;
+        for (int col = -1; col <= _width; ++col)
+        {
+            if (!is_in_bound(row, col))
+                (*this)(row, col) = sentinel;
+        }
     }
-    return *this;
 }
 
-GomokuPatternReconizer::~GomokuPatternReconizer()
+/** GomokuPatternReconizer */
+
+GomokuPatternReconizer::GomokuPatternReconizer(Player player)
+    : _gomoku_player(player),
+      _cached_pattern_count{},
+      _journaling(false),
+      _journal_size(0),
+      _journal_moves_count(0),
+      _journal_overflow_moves(0)
 {
 }
 
@@ -294,168 +239,126 @@ void GomokuPatternReconizer::find_patterns_in_board(const GomokuGame &board)
     adjust_matrices_size(board);
     initialize_matrices_bounds();
     update_all_cells(board);
+    set_journaling(_journaling);
 }
 
-void GomokuPatternReconizer::update_patterns_with_move(const GomokuGame &board, const MoveResult &Count_move)
+void GomokuPatternReconizer::update_patterns_with_move(GomokuPatternReconizer &black, GomokuPatternReconizer &white, const GomokuGame &board, const MoveResult &Count_move, bool journal)
 {
     TIMER
-    for (const CellChange &change : Count_move.cell_changes)
-    {
-        update_cell(board, PatternCellIndex(GomokuCellIndex(change.row, change.col)));
-    }
-}
+    assert(black._gomoku_player == X && white._gomoku_player == O);
 
-void GomokuPatternReconizer::print_patterns()
-{
-    std::cout << "Pattern(" << _gomoku_player << "):" << std::endl;
+    const bool black_journaling = black._journaling;
+    const bool white_journaling = white._journaling;
+    black._journaling = black_journaling && journal;
+    white._journaling = white_journaling && journal;
 
-    std::cout << " Tagged:" << std::endl;
-    for_each_tagged_structures(
-        [](PatternCellIndex index, const PatternCellData &data, PatternDirection direction, bool &should_continue)
-        {
-            std::cout << "  " << direction << " " << data << " [" << int(index.row) << ';' << int(index.col) << "]" << std::endl;
-        });
+    if (black._journaling)
+        black.begin_journaled_move();
+    if (white._journaling)
+        white.begin_journaled_move();
 
-    std::cout << " Cached: {";
-    for (size_t i = 0; i < _cached_pattern_count.size(); i++)
+    for (const CellChange &change : Count_move.cell_changes)
     {
-        std::cout << StructureType(i) << ':' << _cached_pattern_count[i] << (i == _cached_pattern_count.size() - 1 ? "" : ",");
+        update_cell(black, white, board, PatternCellIndex(GomokuCellIndex(change.row, change.col)));
     }
-    std::cout << "}" << std::endl;
+
+    black._journaling = black_journaling;
+    white._journaling = white_journaling;
 }
 
-const std::vector<int> &GomokuPatternReconizer::get_pattern_count() const
+void GomokuPatternReconizer::set_journaling(bool enabled)
 {
-    return _cached_pattern_count;
+    _journaling = enabled;
+    _journal_size = 0;
+    _journal_moves_count = 0;
+    _journal_overflow_moves = 0;
 }
 
-bool GomokuPatternReconizer::five_or_more_cant_be_captured(const GomokuGame &board)
+size_t GomokuPatternReconizer::journaled_moves() const
 {
-    int capturablePatternCount = get_pattern_count()[StructureType::TWO] + get_pattern_count()[StructureType::THREE];
-    if (capturablePatternCount <= 0)
-        return true;
-
-    using CellHashSet = std::unordered_set<PatternCellIndex, Matrix<PatternCellData>::IndexHash>;
-    std::vector<CellHashSet> five_cells;
-    five_cells.reserve(_cached_pattern_count[StructureType::FIVE_OR_MORE]);
-    CellHashSet capturable_indices;
-    capturable_indices.reserve(capturablePatternCount * 2);
-
-    for_each_tagged_structures(
-        [this, &five_cells, &capturable_indices, &board](PatternCellIndex index, const PatternCellData &data, PatternDirection direction, bool &should_continue)
-        {
-            const uint8_t length = data.structure_length();
-            if (length >= 5)
-            {
-                five_cells.emplace_back();
-                for (uint8_t i = 1; i <= length; ++i)
-                {
-                    PatternCellIndex struct_index = get_index_offset(index, direction, -i);
-
-                    five_cells.back().insert(struct_index);
-                }
-            }
-            else if (is_structure_capturable(board, index, data, direction))
-            {
-                for (uint8_t i = 1; i <= length; ++i)
-                {
-                    PatternCellIndex struct_index = get_index_offset(index, direction, -i);
-                    capturable_indices.insert(struct_index);
-                }
-            }
-        });
+    return _journal_moves_count + _journal_overflow_moves;
+}
 
-    auto is_five_capturable = [&capturable_indices](const CellHashSet &five_cell) {
-        for (const PatternCellIndex &index : five_cell)
-        {
-            if (capturable_indices.find(index) != capturable_indices.end())
-            {
-                return true;
-            }
-        }
-        return false;
-    };
+bool GomokuPatternReconizer::undo_patterns_with_move(GomokuPatternReconizer &black, GomokuPatternReconizer &white)
+{
+    TIMER
+    const bool black_restored = black.undo_journaled_move();
+    const bool white_restored = white.undo_journaled_move();
+    return black_restored && white_restored;
+}
 
-    for (const CellHashSet &five_cell : five_cells)
+void GomokuPatternReconizer::begin_journaled_move()
+{
+    if (_journal_moves_count == journal_moves_capacity)
     {
-        if (!is_five_capturable(five_cell))
-            return true;
+        ++_journal_overflow_moves;
+        return;
     }
-    return false;
+    _journal_moves[_journal_moves_count++] = JournalMove{uint16_t(_journal_size), true, _cached_pattern_count};
 }
 
-bool GomokuPatternReconizer::can_be_captured(const GomokuGame &board)
+bool GomokuPatternReconizer::undo_journaled_move()
 {
-    if (get_pattern_count()[StructureType::TWO]
-        // Blocked two can be hidden in gap three
-        + get_pattern_count()[StructureType::THREE] <= 0)
+    if (_journal_overflow_moves > 0)
+    {
+        --_journal_overflow_moves;
         return false;
+    }
+    assert(_journal_moves_count > 0);
 
-    bool capturable = false;
-
-    for_each_tagged_structures(
-        [this, &capturable, &board](PatternCellIndex index, const PatternCellData &data, PatternDirection direction, bool &should_continue)
+    const JournalMove &move = _journal_moves[--_journal_moves_count];
+    if (move.complete)
+    {
+        for (int i = _journal_size; i-- > move.start;)
         {
-            if (is_structure_capturable(board, index, data, direction))
-            {
-                capturable = true;
-                should_continue = false;
-                return;
-            }
-        });
+            const JournalEntry &entry = _journal[i];
+            PatternCellData &cell_data = _cell_matrices[entry.direction][entry.index];
 
-    return capturable;
+            cell_data = entry.old_data;
+        }
+        _cached_pattern_count = move.counts;
+    }
+    _journal_size = move.start;
+    return move.complete;
 }
 
-std::pair<StructureType, PatternCellIndex> GomokuPatternReconizer::get_structure_at(PatternCellIndex index, PatternDirection direction, int min_distance, bool check_first_gap) const
+void GomokuPatternReconizer::print_patterns()
 {
-    const Matrix<PatternCellData> &cell_matrix(_cell_matrices[direction]);
-
-    std::function<std::pair<StructureType, PatternCellIndex>(PatternCellIndex, int, bool, bool)> find_structure;
+    std::cout << "Pattern(" << _gomoku_player << "):" << std::endl;
 
-    find_structure = [&cell_matrix, &find_structure, direction](PatternCellIndex i, int distance, bool try_next, bool met_gap) -> std::pair<StructureType, PatternCellIndex>
+    /** Fives and closed twos, the structures the win checks look at */
+    std::cout << " Fives and closed twos:" << std::endl;
+    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
     {
-        if (!i.is_valid(cell_matrix))
-            return std::make_pair(StructureType::NONE, i);
-
-        const PatternCellData &cell_data(cell_matrix[i]);
-        const PatternCellIndex next = get_index_offset(i, direction, 1);
-
-        /** In case of stone, search the next cell */
-        if (cell_data.sequence_length() > 0)
-            return find_structure(next, distance - 1, false, met_gap);
-
-        /** In case of hole or block, look for the length of the current structure */
-        if (cell_data.structure_length() > 0)
+        const PatternCellMatrix &cell_matrix(_cell_matrices[direction]);
+        for (int row = -1; row <= cell_matrix.get_height(); ++row)
         {
-            /** If we're starting a new closed sequence, then it's a block. No need to go further */
-            if (cell_data.is_sequence_closed())
-                return std::make_pair(cell_data.get_relevant_structure(), i);
-
-            /** case of possible three */
-            if (!met_gap && (cell_data.structure_length() == 1 || cell_data.structure_length() == 2) && (!cell_data.is_gap_open_three()))
+            for (int col = -1; col <= cell_matrix.get_width(); ++col)
             {
-                const std::pair<StructureType, PatternCellIndex> next_structure = find_structure(next, distance - 1, false, true);
-
-                /** If the next structure is a three or open three then it's possibly a continuation of this structure */
-                if (next_structure.first == StructureType::OPEN_THREE || next_structure.first == StructureType::THREE)
-                {
-                    /** If the next structure is itself a different length than three, then it's the second part of this structure */
-                    if (cell_matrix[PatternCellIndex(next_structure.second)].structure_length() != 3)
-                        return next_structure;
-                }
+                const PatternCellData &data = cell_matrix(row, col);
+                const uint8_t length = data.structure_length();
+                if (length >= 5 || (length == 2 && data.is_structure_closed()))
+                    std::cout << "  " << PatternDirection(direction) << " " << data << " [" << row << ';' << col << "]" << std::endl;
             }
-
-            return std::make_pair(cell_data.get_relevant_structure(), i);
         }
+    }
 
-        if (try_next || distance > 0)
-            return find_structure(next, distance - 1, false, met_gap);
+    std::cout << " Cached: {";
+    for (size_t i = 0; i < _cached_pattern_count.size(); i++)
+    {
+        std::cout << StructureType(i) << ':' << _cached_pattern_count[i] << (i == _cached_pattern_count.size() - 1 ? "" : ",");
+    }
+    std::cout << "}" << std::endl;
+}
 
-        return std::make_pair(StructureType::NONE, i);
-    };
+const StructureCounts &GomokuPatternReconizer::get_pattern_count() const
+{
+    return _cached_pattern_count;
+}
 
-    return find_structure(PatternCellIndex(index), min_distance, true, !check_first_gap);
+std::pair<StructureType, PatternCellIndex> GomokuPatternReconizer::get_structure_at(PatternCellIndex index, PatternDirection direction, int min_distance, bool check_first_gap) const
+{
+    return find_structure(_cell_matrices[direction], direction, index, min_distance, true, !check_first_gap);
 }
 
 StructureType GomokuPatternReconizer::highest_structure_around(PatternCellIndex index, int distance) const
@@ -465,26 +368,27 @@ StructureType GomokuPatternReconizer::highest_structure_around(PatternCellIndex
     {
         PatternCellIndex offset = get_index_offset(index, PatternDirection(i), -distance);
         int8_t overflow = 0;
-        if (!offset.is_valid(_cell_matrices[i]))
+        if (!_cell_matrices[i].is_in_padded_bound(offset.row, offset.col))
         {
-            if (offset.col < 0)
+            /** Start from the border instead */
+            if (offset.col < -1)
             {
-                overflow = -offset.col;
+                overflow = -1 - offset.col;
                 offset = get_index_offset(offset, PatternDirection(i), overflow);
             }
-            else if (offset.col >= _cell_matrices[i].get_width())
+            else if (offset.col > _cell_matrices[i].get_width())
             {
-                overflow = offset.col - _cell_matrices[i].get_width() + 1;
+                overflow = offset.col - _cell_matrices[i].get_width();
                 offset = get_index_offset(offset, PatternDirection(i), -overflow);
             }
-            else if (offset.row < 0)
+            else if (offset.row < -1)
             {
-                overflow = -offset.row;
+                overflow = -1 - offset.row;
                 offset = get_index_offset(offset, PatternDirection(i), overflow);
             }
-            else if (offset.row >= _cell_matrices[i].get_height())
+            else if (offset.row > _cell_matrices[i].get_height())
             {
-                overflow = offset.row - _cell_matrices[i].get_height() + 1;
+                overflow = offset.row - _cell_matrices[i].get_height();
                 offset = get_index_offset(offset, PatternDirection(i), -overflow);
             }
         }
@@ -495,7 +399,45 @@ StructureType GomokuPatternReconizer::highest_structure_around(PatternCellIndex
     return highest_structure;
 }
 
-const Matrix<PatternCellData> &GomokuPatternReconizer::get_pattern_cell_matrix(PatternDirection direction) const
+int GomokuPatternReconizer::structure_count_delta_with_stone(const GomokuGame &board, PatternCellIndex index, StructureType type) const
+{
+    int counts[StructureType::COUNT_STRUCTURE_TYPE] = {0};
+
+    /** Same walk as update_cell_line: follow the line until a cell keeps its data */
+    for (int i = 0; i < PatternDirection::Count_PatternDirection; ++i)
+    {
+        const PatternDirection direction = PatternDirection(i);
+        const PatternCellMatrix &cell_matrix(_cell_matrices[direction]);
+
+        PatternCellIndex current = index;
+        int offset = cell_matrix.offset_of(index.row, index.col);
+        PatternCellData previous = cell_matrix.at(offset - 1);
+        PatternCellState state = PatternCellState::Stoned;
+
+        while (true)
+        {
+            const PatternCellData &old_data = cell_matrix.at(offset);
+            const PatternCellData new_data = cell_data_following_memoized(previous, state);
+
+            old_data.get_structures_type_count(counts, -1);
+            new_data.get_structures_type_count(counts, 1);
+
+            current = get_index_offset(current, direction, 1);
+            ++offset;
+            if (!(old_data != new_data) || !cell_matrix.is_in_padded_bound(current.row, current.col))
+                break;
+
+            previous = new_data;
+            state = board.pattern_coordinate_is_valid(current)
+                        ? cell_state_at(board, current)
+                        : PatternCellState::Blocked;
+        }
+    }
+
+    return counts[type];
+}
+
+const PatternCellMatrix &GomokuPatternReconizer::get_pattern_cell_matrix(PatternDirection direction) const
 {
     return _cell_matrices[direction];
 }
@@ -504,7 +446,7 @@ PatternCellState GomokuPatternReconizer::cell_state_at(const GomokuGame &board,
 {
     assert(board.pattern_coordinate_is_valid(index));
 
-    const Player player = board.get_board_value(index.row - 1, index.col - 1);
+    const Player player = board.get_board_value(index.row, index.col);
 
     if (player == _gomoku_player)
         return PatternCellState::Stoned;
@@ -513,16 +455,17 @@ PatternCellState GomokuPatternReconizer::cell_state_at(const GomokuGame &board,
     return PatternCellState::Blocked;
 }
 
-PatternCellData GomokuPatternReconizer::cell_data_following(const PatternCellData &cell, PatternCellState state) const
+/** Calculate the next state from a cell when meeting each state. */
+static constexpr PatternCellData cell_data_following(PatternCellData cell, PatternCellState state)
 {
-    uint8_t sequence_length;
-    bool is_sequence_closed;
-    uint8_t structure_length;
-    bool is_structure_closed;
-    uint8_t previous_structure_length;
-    bool is_previous_structure_closed;
-    bool is_gap_open_three;
-    bool is_gap_open_three_closed;
+    uint8_t sequence_length = 0;
+    bool is_sequence_closed = false;
+    uint8_t structure_length = 0;
+    bool is_structure_closed = false;
+    uint8_t previous_structure_length = 0;
+    bool is_previous_structure_closed = false;
+    bool is_gap_open_three = false;
+    bool is_gap_open_three_closed = false;
 
     switch (state)
     {
@@ -577,33 +520,34 @@ PatternCellData GomokuPatternReconizer::cell_data_following(const PatternCellDat
                            is_gap_open_three_closed);
 }
 
-static uint16_t cell_and_state_to_index(PatternCellData cell, PatternCellState state)
+/** Every transition, indexed by state then cell data */
+using PatternTransitionTable = std::array<PatternCellData, 3 * PatternCellData::combinations_count>;
+
+static constexpr int transition_index(PatternCellData cell, PatternCellState state)
 {
-    return (static_cast<uint16_t>(cell.data()) << 2) | static_cast<uint16_t>(state);
+    return static_cast<int>(state) * PatternCellData::combinations_count + cell.data();
 }
 
-const PatternCellData &GomokuPatternReconizer::cell_data_following_memoized(const PatternCellData &cell, PatternCellState state) const
+static constexpr PatternTransitionTable make_transition_table()
 {
-    const int combinaisons_count = 1 << 16;
-    static PatternCellData cell_values[combinaisons_count];
-    static bool initialized = false;
-
-    if (!initialized)
+    PatternTransitionTable table{};
+    for (int d = 0; d < PatternCellData::combinations_count; ++d)
     {
-        for (uint16_t d = 0; d < 0b100000000000000; ++d)
+        const PatternCellData cell_data(static_cast<uint16_t>(d));
+        for (int state = Empty; state <= Blocked; ++state)
         {
-            PatternCellData cell_data(d);
-            for (int state = 0; state <= 2; ++state)
-            {
-                PatternCellState ss = static_cast<PatternCellState>(state);
-                PatternCellData current = cell_data_following(cell_data, ss);
-                cell_values[cell_and_state_to_index(cell_data, ss)] = current;
-            }
+            const PatternCellState s = static_cast<PatternCellState>(state);
+            table[transition_index(cell_data, s)] = cell_data_following(cell_data, s);
         }
-        initialized = true;
     }
+    return table;
+}
+
+static constexpr PatternTransitionTable transition_table = make_transition_table();
 
-    return cell_values[cell_and_state_to_index(cell, state)];
+PatternCellData GomokuPatternReconizer::cell_data_following_memoized(PatternCellData cell, PatternCellState state)
+{
+    return transition_table[transition_index(cell, state)];
 }
 
 bool GomokuPatternReconizer::adjust_matrices_size(const GomokuGame &board)
@@ -612,14 +556,14 @@ bool GomokuPatternReconizer::adjust_matrices_size(const GomokuGame &board)
 
     for (int i = 0; i < PatternDirection::Count_PatternDirection; ++i)
     {
-        int width = board.get_board_width() + 2;
-        int height = board.get_board_height() + 2;
+        int width = board.get_board_width();
+        int height = board.get_board_height();
 
         const bool size_differ = _cell_matrices[i].get_width() != width || _cell_matrices[i].get_height() != height;
 
         if (size_differ)
         {
-            _cell_matrices[i] = Matrix<PatternCellData>(width, height);
+            _cell_matrices[i] = PatternCellMatrix(PatternDirection(i), width, height);
             modified_matrices = true;
         }
     }
@@ -635,200 +579,239 @@ void GomokuPatternReconizer::initialize_matrices_bounds()
     for (int i = 0; i < PatternDirection::Count_PatternDirection; ++i)
     {
 
-        Matrix<PatternCellData> &mat(_cell_matrices[i]);
-
-        for (int row = 0; row < mat.get_height(); ++row)
-        {
-            mat(row, 0) = out_cell;
-            mat(row, mat.get_width() - 1) = out_cell;
-        }
-        for (int col = 0; col < mat.get_width(); ++col)
-        {
-            mat(0, col) = out_cell;
-            mat(mat.get_height() - 1, col) = out_cell;
-        }
+        _cell_matrices[i].fill_border(out_cell);
     }
 }
 
 void GomokuPatternReconizer::update_all_cells(const GomokuGame &board)
 {
+    const int width = board.get_board_width();
+    const int height = board.get_board_height();
 
     {
-        const int height = _cell_matrices[PatternDirection::LeftToRight].get_height() - 1;
-        PatternCellIndex index(1, 1);
-        for (index.row = 1; index.row < height; ++index.row)
+        PatternCellIndex index(0, 0);
+        for (index.row = 0; index.row < height; ++index.row)
         {
-            update_cell_left_to_right(board, index, true);
+            update_cell_line<PatternDirection::LeftToRight>(board, index, true);
         }
     }
 
     {
-        const int width = _cell_matrices[PatternDirection::UpToDown].get_width() - 1;
-        PatternCellIndex index(1, 1);
-        for (index.col = 1; index.col < width; ++index.col)
+        PatternCellIndex index(0, 0);
+        for (index.col = 0; index.col < width; ++index.col)
         {
-            update_cell_up_to_down(board, index, true);
+            update_cell_line<PatternDirection::UpToDown>(board, index, true);
         }
     }
 
     {
-        const PatternDirection direction = PatternDirection::UpleftToDownright;
-        PatternCellIndex index(1, 1);
-        const int height = _cell_matrices[direction].get_height() - 1;
-        for (index.row = 1; index.row < height; ++index.row)
+        PatternCellIndex index(0, 0);
+        for (index.row = 0; index.row < height; ++index.row)
         {
-            update_cell_upleft_to_downright(board, index, true);
+            update_cell_line<PatternDirection::UpleftToDownright>(board, index, true);
         }
-        const int width = _cell_matrices[direction].get_width() - 1;
-        index.row = 1;
-        for (index.col = 2; index.col < width; ++index.col)
+        index.row = 0;
+        for (index.col = 1; index.col < width; ++index.col)
         {
-            update_cell_upleft_to_downright(board, index, true);
+            update_cell_line<PatternDirection::UpleftToDownright>(board, index, true);
         }
     }
 
     {
-        const PatternDirection direction = PatternDirection::UprightToDownleft;
-        PatternCellIndex index(1, 1);
-        const int width = _cell_matrices[direction].get_width() - 1;
-        for (index.col = 1; index.col < width; ++index.col)
+        PatternCellIndex index(0, 0);
+        for (index.col = 0; index.col < width; ++index.col)
         {
-            update_cell_upright_to_downleft(board, index, true);
+            update_cell_line<PatternDirection::UprightToDownleft>(board, index, true);
         }
-        const int height = _cell_matrices[direction].get_height() - 1;
         index.col = width - 1;
-        for (index.row = 2; index.row < height; ++index.row)
+        for (index.row = 1; index.row < height; ++index.row)
         {
-            update_cell_upright_to_downleft(board, index, true);
+            update_cell_line<PatternDirection::UprightToDownleft>(board, index, true);
         }
     }
 }
 
-void GomokuPatternReconizer::update_cell(const GomokuGame &board, PatternCellIndex index)
+void GomokuPatternReconizer::update_cell(GomokuPatternReconizer &black, GomokuPatternReconizer &white, const GomokuGame &board, PatternCellIndex index)
 {
-    update_cell_left_to_right(board, index);
-    update_cell_up_to_down(board, index);
-    update_cell_upleft_to_downright(board, index);
-    update_cell_upright_to_downleft(board, index);
+    update_cell_line<PatternDirection::LeftToRight>(black, white, board, index);
+    update_cell_line<PatternDirection::UpToDown>(black, white, board, index);
+    update_cell_line<PatternDirection::UpleftToDownright>(black, white, board, index);
+    update_cell_line<PatternDirection::UprightToDownleft>(black, white, board, index);
 }
 
-bool GomokuPatternReconizer::update_cell_direction(
-    const GomokuGame &board,
-    PatternCellIndex index,
-    PatternDirection direction,
-    PatternCellState new_state)
+bool GomokuPatternReconizer::update_cell_direction(PatternCellIndex index, int offset, PatternDirection direction, const PatternCellData &new_data)
 {
-    Matrix<PatternCellData> &cell_matrix(_cell_matrices[direction]);
+    PatternCellMatrix &cell_matrix(_cell_matrices[direction]);
 
-    assert(index.is_valid(cell_matrix));
-    assert(get_index_offset(index, direction, -1).is_valid(cell_matrix));
+    assert(cell_matrix.is_in_padded_bound(index.row, index.col));
+    assert(offset == cell_matrix.offset_of(index.row, index.col));
 
-    const PatternCellData old_data = cell_matrix[index];
+    PatternCellData &cell_data = cell_matrix.at(offset);
+    const PatternCellData old_data = cell_data;
 
-    const PatternCellData new_data = cell_data_following_memoized(
-        cell_matrix[get_index_offset(index, direction, -1)],
-        new_state);
+    if (!(old_data != new_data))
+        return false;
 
-    old_data.get_structures_type_count(_cached_pattern_count, -1);
-    new_data.get_structures_type_count(_cached_pattern_count, 1);
+    old_data.get_structures_type_count(_cached_pattern_count.data(), -1);
+    new_data.get_structures_type_count(_cached_pattern_count.data(), 1);
 
-    if (_tagging_mode)
+    if (_journaling && _journal_overflow_moves == 0 && _journal_moves_count > 0)
     {
-        const bool old_data_relevant = is_relevant_to_tag(old_data);
-        const bool new_data_relevant = is_relevant_to_tag(new_data);
-
-        if (old_data_relevant && !new_data_relevant)
-            untag_celldata_structure(index, direction);
-
-        if (!old_data_relevant && new_data_relevant)
-            tag_celldata_structure(index, direction);
+        if (_journal_size < journal_capacity)
+            _journal[_journal_size++] = JournalEntry{index, direction, old_data};
+        else
+            _journal_moves[_journal_moves_count - 1].complete = false;
     }
 
-    cell_matrix[index] = new_data;
+    cell_data = new_data;
 
-    return old_data != new_data;
+    return true;
 }
 
-void GomokuPatternReconizer::update_cell_left_to_right(const GomokuGame &board, PatternCellIndex index, bool up_to_bound)
-{
-    const PatternDirection direction = PatternDirection::LeftToRight;
+/** Steps of a direction in the pattern matrices and in the matching bitboard line */
+template <PatternDirection direction>
+struct PatternLine;
 
-    PatternCellState new_state =
-        /* index.col - 1 < board.get_board_width() */
-        (index.col <= board.get_board_width())
-            ? cell_state_at(board, index)
-            : PatternCellState::Blocked;
+template <>
+struct PatternLine<PatternDirection::LeftToRight>
+{
+    static constexpr int row_step = 0, col_step = 1, bit_step = 1;
+    static constexpr BitboardLine line = ROWS;
+};
 
-    const bool modified = update_cell_direction(board, index, direction, new_state);
+template <>
+struct PatternLine<PatternDirection::UpToDown>
+{
+    static constexpr int row_step = 1, col_step = 0, bit_step = 1;
+    static constexpr BitboardLine line = COLS;
+};
 
-    if (up_to_bound || modified)
-    {
-        if (++index.col < _cell_matrices[direction].get_width())
-        {
-            update_cell_left_to_right(board, index, up_to_bound);
-        }
-    }
-}
+template <>
+struct PatternLine<PatternDirection::UpleftToDownright>
+{
+    static constexpr int row_step = 1, col_step = 1, bit_step = 1;
+    static constexpr BitboardLine line = DIAGONALS;
+};
 
-void GomokuPatternReconizer::update_cell_up_to_down(const GomokuGame &board, PatternCellIndex index, bool up_to_bound)
+template <>
+struct PatternLine<PatternDirection::UprightToDownleft>
 {
-    const PatternDirection direction = PatternDirection::UpToDown;
+    static constexpr int row_step = 1, col_step = -1, bit_step = -1;
+    static constexpr BitboardLine line = ANTI_DIAGONALS;
+};
 
-    PatternCellState new_state =
-        /* index.row - 1 < board.get_board_height() */
-        (index.row <= board.get_board_height())
-            ? cell_state_at(board, index)
-            : PatternCellState::Blocked;
+template <PatternDirection direction>
+void GomokuPatternReconizer::update_cell_line(const GomokuGame &board, PatternCellIndex index, bool up_to_bound)
+{
+    using Line = PatternLine<direction>;
 
-    const bool modified = update_cell_direction(board, index, direction, new_state);
+    const PatternCellMatrix &cell_matrix(_cell_matrices[direction]);
+    const unsigned int width = board.get_board_width();
+    const unsigned int height = board.get_board_height();
 
-    if (up_to_bound || modified)
+    assert(board.pattern_coordinate_is_valid(index));
+    assert(cell_matrix.is_in_padded_bound(index.row - Line::row_step, index.col - Line::col_step));
+
+    /** States of the whole line are read at once from the bitboard */
+    const GomokuBitboard &bitboard = board.get_bitboard();
+    const uint64_t black = bitboard.line(X, Line::line, index.row, index.col);
+    const uint64_t white = bitboard.line(O, Line::line, index.row, index.col);
+    assert(_gomoku_player == X || _gomoku_player == O);
+    const uint64_t stoned = _gomoku_player == X ? black : white;
+    const uint64_t blocked = _gomoku_player == X ? white : black;
+    int bit = Line::line == COLS ? index.row : index.col;
+
+    /** The line is stored contiguously, the walk follows the offsets */
+    int offset = cell_matrix.offset_of(index.row, index.col);
+    PatternCellData previous = cell_matrix.at(offset - 1);
+
+    while (true)
     {
-        if (++index.row < _cell_matrices[direction].get_height())
+        PatternCellState state = PatternCellState::Blocked;
+        if (unsigned(index.row) < height && unsigned(index.col) < width)
         {
-            update_cell_up_to_down(board, index, up_to_bound);
+            if ((stoned >> bit) & 1)
+                state = PatternCellState::Stoned;
+            else if (!((blocked >> bit) & 1))
+                state = PatternCellState::Empty;
         }
-    }
-}
 
-void GomokuPatternReconizer::update_cell_upleft_to_downright(const GomokuGame &board, PatternCellIndex index, bool up_to_bound)
-{
-    const PatternDirection direction = PatternDirection::UpleftToDownright;
+        const PatternCellData new_data = cell_data_following_memoized(previous, state);
+        const bool modified = update_cell_direction(index, offset, direction, new_data);
 
-    PatternCellState new_state =
-        (index.col <= board.get_board_width() && index.row <= board.get_board_height())
-            ? cell_state_at(board, index)
-            : PatternCellState::Blocked;
+        if (!modified && !up_to_bound)
+            break;
 
-    const bool modified = update_cell_direction(board, index, direction, new_state);
+        index.row += Line::row_step;
+        index.col += Line::col_step;
+        bit += Line::bit_step;
+        ++offset;
+        if (!cell_matrix.is_in_padded_bound(index.row, index.col))
+            break;
 
-    if (up_to_bound || modified)
-    {
-        const Matrix<PatternCellData> &cell_matrix(_cell_matrices[direction]);
-        if (++index.row < cell_matrix.get_height() && ++index.col < cell_matrix.get_width())
-        {
-            update_cell_upleft_to_downright(board, index, up_to_bound);
-        }
+        previous = new_data;
     }
 }
 
-void GomokuPatternReconizer::update_cell_upright_to_downleft(const GomokuGame &board, PatternCellIndex index, bool up_to_bound)
+template <PatternDirection direction>
+void GomokuPatternReconizer::update_cell_line(GomokuPatternReconizer &black, GomokuPatternReconizer &white, const GomokuGame &board, PatternCellIndex index)
 {
-    const PatternDirection direction = PatternDirection::UprightToDownleft;
+    using Line = PatternLine<direction>;
+
+    const PatternCellMatrix &black_matrix(black._cell_matrices[direction]);
+    const PatternCellMatrix &white_matrix(white._cell_matrices[direction]);
+    const unsigned int width = board.get_board_width();
+    const unsigned int height = board.get_board_height();
+
+    assert(board.pattern_coordinate_is_valid(index));
 
-    PatternCellState new_state =
-        (index.col > 0 && index.row <= board.get_board_height())
-            ? cell_state_at(board, index)
-            : PatternCellState::Blocked;
+    const GomokuBitboard &bitboard = board.get_bitboard();
+    const uint64_t black_stones = bitboard.line(X, Line::line, index.row, index.col);
+    const uint64_t white_stones = bitboard.line(O, Line::line, index.row, index.col);
+    int bit = Line::line == COLS ? index.row : index.col;
 
-    const bool modified = update_cell_direction(board, index, direction, new_state);
+    /** Both matrices of a direction share their offsets */
+    int offset = black_matrix.offset_of(index.row, index.col);
+    PatternCellData black_previous = black_matrix.at(offset - 1);
+    PatternCellData white_previous = white_matrix.at(offset - 1);
+    bool black_modified = true;
+    bool white_modified = true;
 
-    if (up_to_bound || modified)
+    while (true)
     {
-        if (++index.row < _cell_matrices[direction].get_height() && --index.col >= 0)
+        /** The board is read once for both players, a stone of one blocks the other */
+        PatternCellState black_state = PatternCellState::Blocked;
+        PatternCellState white_state = PatternCellState::Blocked;
+        if (unsigned(index.row) < height && unsigned(index.col) < width)
         {
-            update_cell_upright_to_downleft(board, index, up_to_bound);
+            if ((black_stones >> bit) & 1)
+                black_state = PatternCellState::Stoned;
+            else if ((white_stones >> bit) & 1)
+                white_state = PatternCellState::Stoned;
+            else
+                black_state = white_state = PatternCellState::Empty;
+        }
+
+        if (black_modified)
+        {
+            black_previous = cell_data_following_memoized(black_previous, black_state);
+            black_modified = black.update_cell_direction(index, offset, direction, black_previous);
         }
+        if (white_modified)
+        {
+            white_previous = cell_data_following_memoized(white_previous, white_state);
+            white_modified = white.update_cell_direction(index, offset, direction, white_previous);
+        }
+
+        if (!black_modified && !white_modified)
+            break;
+
+        index.row += Line::row_step;
+        index.col += Line::col_step;
+        bit += Line::bit_step;
+        ++offset;
+        if (!black_matrix.is_in_padded_bound(index.row, index.col))
+            break;
     }
 }
 
@@ -849,91 +832,46 @@ PatternCellIndex GomokuPatternReconizer::get_index_offset(PatternCellIndex index
     }
 }
 
-void GomokuPatternReconizer::activate_tagging_mode()
+std::pair<StructureType, PatternCellIndex> GomokuPatternReconizer::find_structure(const PatternCellMatrix &cell_matrix, PatternDirection direction, PatternCellIndex index, int distance, bool try_next, bool met_gap)
 {
-    if (_tagging_mode)
-        return;
-
-    _tagging_mode = true;
+    const PatternCellIndex step = get_index_offset(PatternCellIndex(0, 0), direction, 1);
 
-    for (int dir = 0; dir < PatternDirection::Count_PatternDirection; ++dir)
+    for (; cell_matrix.is_in_padded_bound(index.row, index.col); index.row += step.row, index.col += step.col, --distance, try_next = false)
     {
-        PatternCellIndex index(0, 0);
-        for (index.row = 0; index.row < _cell_matrices[dir].get_height(); ++index.row)
+        const PatternCellData &cell_data(cell_matrix[index]);
+
+        /** In case of stone, search the next cell */
+        if (cell_data.sequence_length() > 0)
+            continue;
+
+        /** In case of hole or block, look for the length of the current structure */
+        if (cell_data.structure_length() > 0)
         {
-            for (index.col = 0; index.col < _cell_matrices[dir].get_width(); ++index.col)
+            /** If we're starting a new closed sequence, then it's a block. No need to go further */
+            if (cell_data.is_sequence_closed())
+                return std::make_pair(cell_data.get_relevant_structure(), index);
+
+            /** case of possible three, the next structure is searched once with met_gap so this never goes deeper */
+            if (!met_gap && (cell_data.structure_length() == 1 || cell_data.structure_length() == 2) && (!cell_data.is_gap_open_three()))
             {
-                const PatternCellData &cell_data = _cell_matrices[dir][index];
+                const PatternCellIndex next(index.row + step.row, index.col + step.col);
+                const std::pair<StructureType, PatternCellIndex> next_structure = find_structure(cell_matrix, direction, next, distance - 1, false, true);
 
-                if (is_relevant_to_tag(cell_data))
+                /** If the next structure is a three or open three then it's possibly a continuation of this structure */
+                if (next_structure.first == StructureType::OPEN_THREE || next_structure.first == StructureType::THREE)
                 {
-                    tag_celldata_structure(index, PatternDirection(dir));
+                    /** If the next structure is itself a different length than three, then it's the second part of this structure */
+                    if (cell_matrix[PatternCellIndex(next_structure.second)].structure_length() != 3)
+                        return next_structure;
                 }
             }
-        }
-    }
-}
 
-bool GomokuPatternReconizer::is_relevant_to_tag(const PatternCellData &data) const
-{
-    uint8_t length = data.structure_length();
-
-    if (length >= 5)
-        return true;
-
-    if (length == 2 && data.is_structure_closed())
-        return true;
-
-    return false;
-}
-
-void GomokuPatternReconizer::untag_celldata_structure(PatternCellIndex index, PatternDirection direction)
-{
-    _structure_maps[direction][index.row].erase(index.col);
-}
-
-void GomokuPatternReconizer::tag_celldata_structure(PatternCellIndex index, PatternDirection direction)
-{
-    _structure_maps[direction][index.row].insert(index.col);
-}
-
-void GomokuPatternReconizer::for_each_tagged_structures(std::function<void(PatternCellIndex, const PatternCellData &, PatternDirection, bool &should_continue)> lambda)
-{
-    activate_tagging_mode();
-    bool should_continue = true;
-    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
-    {
-        const auto &structure_map = _structure_maps[direction];
-        for (auto structure_set_row : structure_map)
-        {
-            int row = structure_set_row.first;
-            for (int col : structure_set_row.second)
-            {
-
-                PatternCellIndex index(row, col);
-                PatternCellData data = _cell_matrices[direction](row, col);
-
-                lambda(index, data, PatternDirection(direction), should_continue);
-
-                if (!should_continue)
-                    return;
-            }
+            return std::make_pair(cell_data.get_relevant_structure(), index);
         }
-    }
-}
-
-bool GomokuPatternReconizer::is_structure_capturable(const GomokuGame &board, PatternCellIndex index, const PatternCellData &data, PatternDirection direction) const
-{
-    if (data.structure_length() == 2 && data.is_structure_closed())
-    {
-        const bool index_is_valid = board.pattern_coordinate_is_valid(index);
-        if (index_is_valid)
-        {
-            const PatternCellIndex opposite_side_index = get_index_offset(index, direction, -3);
-            const bool opposite_side_is_valid = board.pattern_coordinate_is_valid(opposite_side_index);
 
-            return opposite_side_is_valid;
-        }
+        if (!try_next && distance <= 0)
+            return std::make_pair(StructureType::NONE, index);
     }
-    return false;
+
+    return std::make_pair(StructureType::NONE, index);
 }
@@ -0,0 +1,183 @@
+#include "engine/gomoku_window_reconizer.h"
+#include <array>
+
+static constexpr int window_radius = GomokuWindowReconizer::window_radius;
+static constexpr int window_size = GomokuWindowReconizer::window_size;
+
+/** Type of a sequence of stones from its length and flanks, bounded on both sides it isn't a structure */
+static constexpr StructureType sequence_structure(int length, bool start_blocked, bool end_blocked)
+{
+    if (length >= 5)
+        return StructureType::FIVE_OR_MORE;
+    if (start_blocked && end_blocked)
+        return StructureType::NONE;
+    return StructureType(length * 2 + (start_blocked || end_blocked ? 1 : 0));
+}
+
+/** Structure going through the center of the window.
+ * A sequence shorter than five never reaches the window bounds, so its flanks are in the window,
+ * and so are the flanks of a gaped three.
+ */
+static constexpr StructureType center_structure(const PatternCellState *cells)
+{
+    if (cells[window_radius] != Stoned)
+        return StructureType::NONE;
+
+    int start = window_radius;
+    int end = window_radius;
+    while (start > 0 && cells[start - 1] == Stoned)
+        --start;
+    while (end < window_size - 1 && cells[end + 1] == Stoned)
+        ++end;
+
+    const int length = end - start + 1;
+    if (length >= 5)
+        return StructureType::FIVE_OR_MORE;
+
+    StructureType structure = sequence_structure(length, cells[start - 1] == Blocked, cells[end + 1] == Blocked);
+    if (length >= 3)
+        return structure;
+
+    /** Look for the other part of a gaped three on each side of the gap */
+    for (int side = -1; side <= 1; side += 2)
+    {
+        const int gap = side < 0 ? start - 1 : end + 1;
+        int other_end = gap + side;
+        if (cells[gap] != Empty || other_end < 0 || other_end >= window_size || cells[other_end] != Stoned)
+            continue;
+
+        int other_start = other_end;
+        while (other_start + side >= 0 && other_start + side < window_size && cells[other_start + side] == Stoned)
+            other_start += side;
+
+        const int other_length = (other_start - other_end) * side + 1;
+        if (length + other_length != 3)
+            continue;
+
+        const bool outer_blocked = cells[other_start + side] == Blocked;
+        const bool inner_blocked = cells[side < 0 ? end + 1 : start - 1] == Blocked;
+        if (outer_blocked && inner_blocked)
+            continue;
+        if (!outer_blocked && !inner_blocked)
+            return StructureType::OPEN_THREE;
+        structure = StructureType::THREE;
+    }
+
+    return structure;
+}
+
+/** Structure and gain of each window, indexed by its base 3 key */
+using WindowPatternTable = std::array<WindowPattern, GomokuWindowReconizer::combinations_count>;
+
+static constexpr WindowPatternTable make_window_table()
+{
+    WindowPatternTable table{};
+    for (int key = 0; key < GomokuWindowReconizer::combinations_count; ++key)
+    {
+        PatternCellState cells[window_size] = {};
+        int digits = key;
+        for (int i = 0; i < window_size; ++i)
+        {
+            cells[i] = PatternCellState(digits % 3);
+            digits /= 3;
+        }
+
+        table[key].structure = center_structure(cells);
+        table[key].gain = StructureType::NONE;
+        if (cells[window_radius] == Empty)
+        {
+            cells[window_radius] = Stoned;
+            table[key].gain = center_structure(cells);
+        }
+    }
+    return table;
+}
+
+static constexpr WindowPatternTable window_table = make_window_table();
+
+/** Value in base 3 of each window_size bits mask */
+using TernaryTable = std::array<uint16_t, 1 << window_size>;
+
+static constexpr TernaryTable make_ternary_table()
+{
+    TernaryTable table{};
+    for (int mask = 0; mask < (1 << window_size); ++mask)
+    {
+        int value = 0;
+        for (int bit = window_size - 1; bit >= 0; --bit)
+            value = value * 3 + ((mask >> bit) & 1);
+        table[mask] = value;
+    }
+    return table;
+}
+
+static constexpr TernaryTable ternary_table = make_ternary_table();
+
+static constexpr BitboardLine line_of_direction[PatternDirection::Count_PatternDirection] = {
+    BitboardLine::ROWS,
+    BitboardLine::COLS,
+    BitboardLine::DIAGONALS,
+    BitboardLine::ANTI_DIAGONALS,
+};
+
+/** GomokuWindowReconizer */
+
+GomokuWindowReconizer::GomokuWindowReconizer(Player player)
+    : _gomoku_player(player)
+{
+}
+
+WindowPattern GomokuWindowReconizer::pattern_at(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction) const
+{
+    return window_table[window_key(bitboard, _gomoku_player, row, col, direction)];
+}
+
+StructureType GomokuWindowReconizer::structure_at(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction) const
+{
+    return pattern_at(bitboard, row, col, direction).structure;
+}
+
+StructureType GomokuWindowReconizer::gain_at(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction) const
+{
+    return pattern_at(bitboard, row, col, direction).gain;
+}
+
+StructureType GomokuWindowReconizer::highest_gain_at(const GomokuBitboard &bitboard, int row, int col) const
+{
+    StructureType highest_gain = StructureType::NONE;
+    for (int i = 0; i < PatternDirection::Count_PatternDirection; ++i)
+    {
+        const StructureType gain = gain_at(bitboard, row, col, PatternDirection(i));
+        if (compare_structure_type(highest_gain, gain))
+            highest_gain = gain;
+    }
+    return highest_gain;
+}
+
+void GomokuWindowReconizer::patterns_around(const GomokuBitboard &bitboard, int row, int col, PatternDirection direction, WindowPattern *black_patterns, WindowPattern *white_patterns)
+{
+    uint32_t black = 0;
+    uint32_t black_blocked = 0;
+    uint32_t white = 0;
+    uint32_t white_blocked = 0;
+    bitboard.window(X, line_of_direction[direction], row, col, 2 * window_radius, black, black_blocked);
+    bitboard.window(O, line_of_direction[direction], row, col, 2 * window_radius, white, white_blocked);
+
+    constexpr uint32_t window_mask = (1 << window_size) - 1;
+    for (int distance = -window_radius; distance <= window_radius; ++distance)
+    {
+        /** Bits go the other way along the anti diagonals */
+        const int shift = window_radius + (direction == PatternDirection::UprightToDownleft ? -distance : distance);
+
+        black_patterns[distance + window_radius] = window_table[ternary_table[(black >> shift) & window_mask] * Stoned + ternary_table[(black_blocked >> shift) & window_mask] * Blocked];
+        white_patterns[distance + window_radius] = window_table[ternary_table[(white >> shift) & window_mask] * Stoned + ternary_table[(white_blocked >> shift) & window_mask] * Blocked];
+    }
+}
+
+int GomokuWindowReconizer::window_key(const GomokuBitboard &bitboard, Player player, int row, int col, PatternDirection direction)
+{
+    uint32_t stones = 0;
+    uint32_t blocked = 0;
+    bitboard.window(player, line_of_direction[direction], row, col, window_radius, stones, blocked);
+    return ternary_table[stones] * Stoned + ternary_table[blocked] * Blocked;
+}
@@ -5,6 +5,7 @@
 #include "engine/gomoku_engine.h"
 #include "room/game_room.h"
 #include "utils/gomoku_utilities.h"
+#include <chrono>
 #include <fstream>
 
 void test_problems()
@@ -142,8 +143,8 @@ void test_problem(int problem_idx)
     logMoveEvaluation(moveEvalutation, "log.txt");
     Timer::printAccumulatedTimes();
 
-    std::vector<int> X_patterns = game.get_patterns_count(X);
-    std::vector<int> O_patterns = game.get_patterns_count(O);
+    StructureCounts X_patterns = game.get_patterns_count(X);
+    StructureCounts O_patterns = game.get_patterns_count(O);
     std::cout << "X patterns: ";
     for (int pattern : X_patterns)
     {
@@ -276,21 +277,21 @@ void test_line(const std::string &line)
 
     reconizer.find_patterns_in_board(game);
 
-    const Matrix<PatternCellData> &line_mat = reconizer.get_pattern_cell_matrix(PatternDirection::LeftToRight);
+    const PatternCellMatrix &line_mat = reconizer.get_pattern_cell_matrix(PatternDirection::LeftToRight);
 
-    for (int col = 0; col < line_mat.get_width(); ++col)
+    for (int col = -1; col <= line_mat.get_width(); ++col)
     {
-        PatternCellData cell_data = line_mat(1, col);
+        PatternCellData cell_data = line_mat(0, col);
 
         std::vector<int> all_structures(StructureType::COUNT_STRUCTURE_TYPE, 0);
         cell_data.get_structures_type_count(all_structures);
 
-        char cell_state = (col > 0 && col <= int(line.size())) ? line[col - 1] : 'X';
+        char cell_state = (col >= 0 && col < int(line.size())) ? line[col] : 'X';
 
-        auto cell_pattern = reconizer.get_structure_at(GomokuCellIndex(0, col - 1), PatternDirection::LeftToRight);
+        auto cell_pattern = reconizer.get_structure_at(GomokuCellIndex(0, col), PatternDirection::LeftToRight);
         StructureType has_struct[3];
         for (int i = 0; i < 3; i++)
-            has_struct[i] = reconizer.highest_structure_around(GomokuCellIndex(0, col - 1), i);
+            has_struct[i] = reconizer.highest_structure_around(GomokuCellIndex(0, col), i);
 
         std::cout << cell_state << " -> " << cell_data << " " << all_structures << " "
                   << "structat=" << cell_pattern.first << "[" << int(cell_pattern.second.col) << "]"
@@ -356,6 +357,54 @@ void fight(std::string ai_name1, std::string ai_name2)
     Timer::printAccumulatedTimes();
 }
 
+/** Time a query over some iterations and print the average duration of one */
+template <typename Function>
+void bench(const std::string &name, int iterations, Function f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        f();
+    const auto end = std::chrono::steady_clock::now();
+
+    const double total_ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << name << ": " << total_ns / iterations << " ns" << std::endl;
+}
+
+void bench_structures()
+{
+    GomokuGame game(19, 19);
+    apply_moves(game, "99,88,8A,9A,79,A9,7A,6B,98,87,97,96,A7,B6,89,78,69,5A,B8,C9,86,75,A8,C8");
+
+    const GomokuPatternReconizer &reconizer = game.get_pattern_reconizer(X);
+    int checksum = 0;
+
+    bench("highest_structure_around (all empty cells)", 2000, [&]()
+          {
+        for (int row = 0; row < 19; ++row)
+            for (int col = 0; col < 19; ++col)
+                if (game.get_board_value(row, col) == E)
+                    checksum += reconizer.highest_structure_around(GomokuCellIndex(row, col), 2); });
+
+    /** A five next to capturable twos, so the capture checks have a five to look at */
+    for (int col = 2; col < 7; ++col)
+        game.set_board_value(3, col, X);
+    const GomokuBitboard &bitboard = game.get_bitboard();
+    bench("has_uncapturable_five", 200000, [&]()
+          { checksum += bitboard.has_uncapturable_five(X); });
+    bench("set_board_value (place and remove a stone)", 200000, [&]()
+          {
+        game.set_board_value(12, 12, O);
+        game.set_board_value(12, 12, E); });
+
+    GomokuGame snapshot(19, 19);
+    bench("copy game", 200000, [&]()
+          {
+        snapshot = game;
+        checksum += snapshot.get_player_score(X); });
+
+    std::cout << "checksum: " << checksum << std::endl;
+}
+
 int main(int argc, char *argv[])
 {
     // If no arguments are given, run the test_problems function
@@ -392,6 +441,10 @@ int main(int argc, char *argv[])
     {
         fight(argv[2], argv[3]);
     }
+    else if (arg1 == "bench")
+    {
+        bench_structures();
+    }
     else
     {
         test_problem(atoi(argv[1]));
@@ -23,6 +23,8 @@ PYBIND11_MODULE(pygomoku, m)
         .def("get_board_height", &GomokuGame::get_board_height)
         .def("get_current_player", &GomokuGame::get_current_player)
         .def("get_player_score", &GomokuGame::get_player_score)
+        .def("get_hash", &GomokuGame::get_hash)
+        .def("is_double_three", &GomokuGame::is_double_three)
         .def("reverse_move", &GomokuGame::reverse_move)
         .def("reapply_move", &GomokuGame::reapply_move)
         .def("print_patterns", &GomokuGame::print_patterns);
@@ -34,7 +36,8 @@ PYBIND11_MODULE(pygomoku, m)
         .def_readwrite("new_value", &CellChange::new_value);
     py::class_<MoveResult>(m, "MoveResult")
         .def(py::init<>())
-        .def_readwrite("cell_changes", &MoveResult::cell_changes)
+        .def_property_readonly("cell_changes", [](const MoveResult &result)
+                               { return std::vector<CellChange>(result.cell_changes.begin(), result.cell_changes.end()); })
         .def_readwrite("white_score_change", &MoveResult::white_score_change)
         .def_readwrite("black_score_change", &MoveResult::black_score_change);
     py::enum_<Player>(m, "Player")
@@ -88,7 +91,9 @@ PYBIND11_MODULE(pygomoku, m)
     py::class_<GameEntitySetting>(m, "GameEntitySetting")
         .def(py::init<>())
         .def_readwrite("is_ai", &GameEntitySetting::is_ai)
-        .def_readwrite("ai_name", &GameEntitySetting::ai_name);
+        .def_readwrite("ai_name", &GameEntitySetting::ai_name)
+        .def_readwrite("time_budget_ms", &GameEntitySetting::time_budget_ms)
+        .def_readwrite("node_limit", &GameEntitySetting::node_limit);
 
     m.def("get_ai_names_list", &get_ai_names_list);
 
@@ -1,6 +1,7 @@
 #include "ai/gomoku_ai_minmaxv2.h"
 #include "ai/gomoku_ai_minmaxv3.h"
 #include "room/game_room.h"
+#include <algorithm>
 
 static const AI::MinMaxV2::GomokuAIData ai_data_default = AI::MinMaxV2::GomokuAIData();
 
@@ -78,28 +79,48 @@ static const AI::MinMaxV2::GomokuAIData ai_data_cpu4 = []()
     return data;
 }();
 
+// Deepest iteration of an AI playing with a time budget
+static const int budgeted_max_depth = 10;
+
+static int search_depth(int depth, const GameEntitySetting &setting)
+{
+    return setting.time_budget_ms > 0 ? std::max(depth, budgeted_max_depth) : depth;
+}
+
 // Function to create AI
-AI::IGomokuAI *create_aiv2(int depth, int length, const AI::MinMaxV2::GomokuAIData &data)
+AI::IGomokuAI *create_aiv2(int depth, int length, const AI::MinMaxV2::GomokuAIData &data, const GameEntitySetting &setting)
 {
-    return new AI::MinMaxV2::GomokuAI({depth, length, data});
+    AI::MinMaxV2::GomokuAiSettings settings;
+    settings.depth = search_depth(depth, setting);
+    settings.length = length;
+    settings.data = data;
+    settings.time_budget_ms = setting.time_budget_ms;
+    settings.node_limit = setting.node_limit;
+    return new AI::MinMaxV2::GomokuAI(settings);
 }
 
-AI::IGomokuAI *create_aiv3(int depth, int length, const AI::MinMaxV3::GomokuAIData &data)
+AI::IGomokuAI *create_aiv3(int depth, int length, const AI::MinMaxV3::GomokuAIData &data, const GameEntitySetting &setting)
 {
-    return new AI::MinMaxV3::GomokuAI({depth, length, data});
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = search_depth(depth, setting);
+    settings.length = length;
+    settings.data = data;
+    settings.time_budget_ms = setting.time_budget_ms;
+    settings.node_limit = setting.node_limit;
+    return new AI::MinMaxV3::GomokuAI(settings);
 }
 
 // Helper macros to simplify AI creation functions
-#define CREATE_AI_FUNC(name, depth, length, data) \
-    AI::IGomokuAI *create_##name##_ai()           \
-    {                                             \
-        return create_aiv2(depth, length, data);  \
+#define CREATE_AI_FUNC(name, depth, length, data)                       \
+    AI::IGomokuAI *create_##name##_ai(const GameEntitySetting &setting) \
+    {                                                                   \
+        return create_aiv2(depth, length, data, setting);               \
     }
 
-#define CREATE_AI_FUNCV3(name, depth, length, data) \
-    AI::IGomokuAI *create_##name##_ai()             \
-    {                                               \
-        return create_aiv2(depth, length, data);    \
+#define CREATE_AI_FUNCV3(name, depth, length, data)                     \
+    AI::IGomokuAI *create_##name##_ai(const GameEntitySetting &setting) \
+    {                                                                   \
+        return create_aiv2(depth, length, data, setting);               \
     }
 
 CREATE_AI_FUNC(default, 3, 2, ai_data_default)
@@ -132,7 +153,7 @@ CREATE_AI_FUNC(cpu4_d4, 4, 2, ai_data_cpu4)
 CREATE_AI_FUNC(cpu4_d5, 5, 2, ai_data_cpu4)
 CREATE_AI_FUNC(cpu4_d6, 6, 2, ai_data_cpu4)
 
-static const std::vector<std::pair<std::string, std::function<AI::IGomokuAI *()>>>
+static const std::vector<std::pair<std::string, std::function<AI::IGomokuAI *(const GameEntitySetting &)>>>
     ai_makers = {
         {"default", create_default_ai},
         {"default_d4", create_default_d4_ai},
@@ -176,7 +197,7 @@ AI::IGomokuAI *GameEntitySetting::make_ai() const
     for (const auto &[name, maker] : ai_makers)
     {
         if (name == ai_name)
-            return maker();
+            return maker(*this);
     }
 
     return nullptr;
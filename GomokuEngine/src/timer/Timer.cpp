@@ -1,8 +1,8 @@
 #include "timer/Timer.h"
 
-std::map<Timer::CallStack, FunctionAccumulation> Timer::accumulatedFunctions;
-std::stack<Timer::CallStack> Timer::callStacks;
-std::map<std::string, int> Timer::activeFunctions;
+thread_local std::map<Timer::CallStack, FunctionAccumulation> Timer::accumulatedFunctions;
+thread_local std::stack<Timer::CallStack> Timer::callStacks;
+thread_local std::map<std::string, int> Timer::activeFunctions;
 
 Timer::Timer(const std::string &name) : functionName(name), isRecursive(false)
 {
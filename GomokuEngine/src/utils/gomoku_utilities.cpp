@@ -57,7 +57,7 @@ std::string to_string(const GomokuGame &game, bool with_coordinates, int distanc
         }
         else if (distance == -1)
         {
-            if (cell_set_contains(relevant_cells, row, col))
+            if (relevant_cells.contains(row, col))
                 ss << "*";
             else
                 ss << value;
@@ -1,7 +1,12 @@
 #include "ai/gomoku_ai_minmaxv2.h"
 #include "ai/gomoku_ai_minmaxv3.h"
+#include "ai/gomoku_ai_transposition_table.h"
 #include "engine/gomoku_engine.h"
+#include "utils/gomoku_utilities.h"
 #include "gtest/gtest.h"
+#include <limits>
+#include <stdexcept>
+#include <thread>
 
 TEST(AiTest_MinMaxV2, Creation)
 {
@@ -23,6 +28,316 @@ TEST(AiTest_MinMaxV3, Creation)
     AI::MinMaxV3::GomokuAI ai(settings);
 }
 
+TEST(AiTest_TranspositionTable, StoreAndProbe)
+{
+    AI::TranspositionTable table(1000);
+
+    EXPECT_EQ(table.size(), 512);
+
+    AI::TranspositionEntry entry;
+    EXPECT_FALSE(table.probe(42, entry));
+
+    entry.score = -1234;
+    entry.depth = 3;
+    entry.bound = AI::TranspositionBound::LOWER;
+    entry.row = 9;
+    entry.col = 10;
+    table.store(42, entry);
+
+    AI::TranspositionEntry found;
+    ASSERT_TRUE(table.probe(42, found));
+    EXPECT_EQ(found.score, -1234);
+    EXPECT_EQ(found.depth, 3);
+    EXPECT_EQ(found.bound, AI::TranspositionBound::LOWER);
+    EXPECT_EQ(found.row, 9);
+    EXPECT_EQ(found.col, 10);
+
+    /** Same slot, different position */
+    EXPECT_FALSE(table.probe(42 + 512, found));
+
+    /** Shallower results don't replace deeper ones of the same position */
+    entry.depth = 1;
+    entry.score = 7;
+    table.store(42, entry);
+    ASSERT_TRUE(table.probe(42, found));
+    EXPECT_EQ(found.score, -1234);
+
+    table.clear();
+    EXPECT_FALSE(table.probe(42, found));
+}
+
+TEST(AiTest_TranspositionTable, ConcurrentStoresStayConsistent)
+{
+    AI::TranspositionTable table(64);
+    std::vector<std::thread> threads;
+
+    // Every entry stores its key in its score, a torn entry would not match
+    auto store_and_probe = [&table](int t)
+    {
+        for (uint64_t i = 0; i < 20000; ++i)
+        {
+            const uint64_t key = i * 4 + t;
+            AI::TranspositionEntry entry;
+            entry.score = int(key);
+            entry.depth = int8_t(t);
+            table.store(key, entry);
+
+            AI::TranspositionEntry found;
+            const uint64_t other_key = (i + 1) * 4 + (t + 1) % 4;
+            if (table.probe(other_key, found))
+            {
+                EXPECT_EQ(uint64_t(found.score), other_key);
+            }
+        }
+    };
+
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back(store_and_probe, t);
+    for (auto &thread : threads)
+        thread.join();
+}
+
+TEST(AiTest_MinMaxV3, TranspositionTableFindsWin)
+{
+    GomokuGame game(19, 19);
+    apply_moves(game, "44,64,45,65,46,66,47,67");
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 3;
+
+    AI::MinMaxV3::GomokuAI ai(settings);
+    AI::Move move = ai.suggest_move(game);
+
+    EXPECT_EQ(move.row, 4);
+    EXPECT_TRUE(move.col == 8 || move.col == 3);
+    EXPECT_GT(ai.get_search_statistics().nodes, 0);
+}
+
+TEST(AiTest_MinMaxV3, TranspositionTableKeepsBoardSizesApart)
+{
+    /** The same stones near the edge of a smaller board */
+    const char *moves = "66,A6,67,A7";
+    GomokuGame large_game(19, 19);
+    apply_moves(large_game, moves);
+    GomokuGame small_game(11, 11);
+    apply_moves(small_game, moves);
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 4;
+
+    AI::MinMaxV3::GomokuAI fresh_ai(settings);
+    AI::MinMaxV3::MoveEvaluation expected = fresh_ai.suggest_move_evaluation(small_game);
+
+    AI::MinMaxV3::GomokuAI reused_ai(settings);
+    reused_ai.suggest_move_evaluation(large_game);
+    AI::MinMaxV3::MoveEvaluation result = reused_ai.suggest_move_evaluation(small_game);
+
+    EXPECT_EQ(AI::MinMaxV3::getBestMove(result, true), AI::MinMaxV3::getBestMove(expected, true));
+    EXPECT_EQ(result.score, expected.score);
+    EXPECT_EQ(reused_ai.get_search_statistics().nodes, fresh_ai.get_search_statistics().nodes);
+}
+
+TEST(AiTest_MinMaxV2, NodeLimitFindsWin)
+{
+    GomokuGame game(19, 19);
+    apply_moves(game, "44,64,45,65,46,66,47,67");
+
+    AI::MinMaxV2::GomokuAiSettings settings;
+    settings.depth = 10;
+    settings.node_limit = 5000;
+
+    AI::MinMaxV2::GomokuAI ai(settings);
+    AI::Move move = ai.suggest_move(game);
+
+    EXPECT_EQ(move.row, 4);
+    EXPECT_TRUE(move.col == 8 || move.col == 3);
+}
+
+TEST(AiTest_MinMaxV3, TimeBudgetStopsSearch)
+{
+    GomokuGame game(19, 19);
+    apply_moves(game, "99,9A,A9,88,AA,8A");
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 10;
+    settings.time_budget_ms = 100;
+
+    AI::MinMaxV3::GomokuAI ai(settings);
+    AI::Move move = ai.suggest_move(game);
+
+    /** The budget stops the deepening, the last completed iteration gives the move */
+    EXPECT_TRUE(game.coordinates_are_valid(move.row, move.col));
+    EXPECT_EQ(game.get_board_value(move.row, move.col), E);
+    EXPECT_GE(ai.get_search_statistics().completed_depth, 1);
+    EXPECT_LT(ai.get_search_statistics().completed_depth, 10);
+}
+
+TEST(AiTest_MinMaxV3, NodeLimitStopsSearch)
+{
+    GomokuGame game(19, 19);
+    apply_moves(game, "99,9A,A9,88,AA,8A");
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 10;
+    settings.node_limit = 45000;
+
+    AI::MinMaxV3::GomokuAI ai(settings);
+    AI::Move move = ai.suggest_move(game);
+
+    /** The first iteration always completes, the cap stops a later one */
+    EXPECT_TRUE(game.coordinates_are_valid(move.row, move.col));
+    EXPECT_EQ(game.get_board_value(move.row, move.col), E);
+    EXPECT_EQ(ai.get_search_statistics().nodes, settings.node_limit);
+    EXPECT_GE(ai.get_search_statistics().completed_depth, 1);
+    EXPECT_LT(ai.get_search_statistics().completed_depth, 10);
+}
+
+TEST(AiTest_MinMaxV3, HelperThreadsFindForcedWin)
+{
+    /** Helpers search one ply deeper and share the transposition table, the main search may cut on
+     * their entries in any order: only what holds for every schedule is checked.
+     * Problem 9: a 4th capture turning into a 5th one */
+    GomokuGame game(19, 19);
+    apply_moves(game, "44,45,74,75,1G,A4,4G,A5,7G,46,AG,76,DG,DF,GG,DE,HD,AF,DD,AE,AD,7F,G7,7E,7D,A6,04,05,G0,06");
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 3;
+    settings.threads = 4;
+
+    AI::MinMaxV3::GomokuAI ai(settings);
+    AI::MinMaxV3::MoveEvaluation result = ai.suggest_move_evaluation(game);
+    const std::pair<int, int> move = AI::MinMaxV3::getBestMove(result, true);
+
+    EXPECT_EQ(result.score, std::numeric_limits<int>::max());
+    ASSERT_TRUE(game.coordinates_are_valid(move.first, move.second));
+    EXPECT_EQ(game.get_board_value(move.first, move.second), E);
+    EXPECT_EQ(ai.get_search_statistics().threads, 4);
+    EXPECT_EQ(ai.get_search_statistics().completed_depth, 3);
+
+    /** Problem 5: a quiet position, the search still completes with a legal move */
+    GomokuGame quiet_game(19, 19);
+    apply_moves(quiet_game, "74,63,75,53,43,00,42,0I");
+
+    settings.depth = 4;
+    AI::MinMaxV3::GomokuAI quiet_ai(settings);
+    result = quiet_ai.suggest_move_evaluation(quiet_game);
+    const std::pair<int, int> quiet_move = AI::MinMaxV3::getBestMove(result, true);
+
+    ASSERT_TRUE(quiet_game.coordinates_are_valid(quiet_move.first, quiet_move.second));
+    EXPECT_EQ(quiet_game.get_board_value(quiet_move.first, quiet_move.second), E);
+    EXPECT_EQ(quiet_ai.get_search_statistics().completed_depth, 4);
+}
+
+TEST(AiTest_MinMaxV3, HelperThreadsNeedTranspositionTable)
+{
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.threads = 4;
+    settings.transposition_table_size = 0;
+
+    EXPECT_THROW(AI::MinMaxV3::GomokuAI ai(settings), std::invalid_argument);
+}
+
+TEST(AiTest_MinMaxV3, GainMoveOrderingRanksForcingMovesFirst)
+{
+    /** X has an open three on row 4 and would make a double three on A9, O stones are quiet */
+    GomokuGame game(19, 19);
+    apply_moves(game, "44,00,45,0I,46,I0,AA,II,AB,09,B9,90,C9,9I");
+    ASSERT_TRUE(game.is_double_three(10, 9, X));
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 2;
+    settings.gain_move_ordering = true;
+
+    /** The root keeps its moves in the order they were searched */
+    AI::MinMaxV3::GomokuAI ai(settings);
+    AI::MinMaxV3::MoveEvaluation result = ai.suggest_move_evaluation(game);
+    const std::vector<AI::MinMaxV3::MoveHeuristic> &moves = result.relevant_moves;
+
+    ASSERT_FALSE(moves.empty());
+    EXPECT_EQ(moves[0].row, 4);
+    EXPECT_TRUE(moves[0].col == 3 || moves[0].col == 7);
+    EXPECT_GT(moves[0].score, 0);
+    for (size_t i = 1; i < moves.size(); ++i)
+    {
+        EXPECT_GE(moves[i - 1].score, moves[i].score);
+        EXPECT_FALSE(moves[i].row == 10 && moves[i].col == 9) << "illegal double three kept";
+    }
+    /** Cells next to a lone O stone are worth less than the open four */
+    const auto quiet = std::find_if(moves.begin(), moves.end(), [](const AI::MinMaxV3::MoveHeuristic &move)
+                                    { return move.row == 1 && move.col == 1; });
+    ASSERT_NE(quiet, moves.end());
+    EXPECT_LT(quiet->score, moves[0].score);
+}
+
+TEST(AiTest_MinMaxV3, GainMoveOrderingMatchesDefaultOrdering)
+{
+    /** Problem 10: create an open three, not decided in one move */
+    GomokuGame game(19, 19);
+    apply_moves(game, "66,A6,67,A7");
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 4;
+
+    AI::MinMaxV3::GomokuAI default_ordering(settings);
+    AI::MinMaxV3::MoveEvaluation expected = default_ordering.suggest_move_evaluation(game);
+
+    settings.gain_move_ordering = true;
+    AI::MinMaxV3::GomokuAI gain_ordering(settings);
+    AI::MinMaxV3::MoveEvaluation result = gain_ordering.suggest_move_evaluation(game);
+
+    EXPECT_EQ(AI::MinMaxV3::getBestMove(result, true), AI::MinMaxV3::getBestMove(expected, true));
+    EXPECT_EQ(result.score, expected.score);
+    EXPECT_LT(gain_ordering.get_search_statistics().nodes, default_ordering.get_search_statistics().nodes);
+}
+
+TEST(AiTest_MinMaxV3, PrincipalVariationSearchMatchesAlphaBeta)
+{
+    /** Problems 4, 6 and 10, where some moves fall inside the window after a null window search.
+     * Without searching them again problem 6 blocks the wrong side of the open three */
+    for (const char *moves : {"44,64,45,65,46,43,47", "44,64,45,65,46", "66,A6,67,A7"})
+    {
+        GomokuGame game(19, 19);
+        apply_moves(game, moves);
+
+        AI::MinMaxV3::GomokuAiSettings settings;
+        settings.depth = 4;
+
+        AI::MinMaxV3::GomokuAI alpha_beta(settings);
+        AI::MinMaxV3::MoveEvaluation expected = alpha_beta.suggest_move_evaluation(game);
+
+        settings.principal_variation_search = true;
+        AI::MinMaxV3::GomokuAI principal_variation(settings);
+        AI::MinMaxV3::MoveEvaluation result = principal_variation.suggest_move_evaluation(game);
+
+        EXPECT_EQ(AI::MinMaxV3::getBestMove(result, true), AI::MinMaxV3::getBestMove(expected, true)) << moves;
+        EXPECT_EQ(result.score, expected.score) << moves;
+        EXPECT_GT(principal_variation.get_search_statistics().pvs_researches, 0) << moves;
+    }
+}
+
+TEST(AiTest_MinMaxV3, AspirationWindowMatchesFullWindow)
+{
+    /** The score of the second and third iterations falls out of a narrow window around the previous one */
+    GomokuGame game(19, 19);
+    apply_moves(game, "A8,87,99,88,A9,97,AA,98,B9,9B,B7,78");
+
+    AI::MinMaxV3::GomokuAiSettings settings;
+    settings.depth = 3;
+    settings.time_budget_ms = 100000;
+
+    AI::MinMaxV3::GomokuAI full_window(settings);
+    AI::MinMaxV3::MoveEvaluation expected = full_window.suggest_move_evaluation(game);
+
+    settings.aspiration_window = 10;
+    AI::MinMaxV3::GomokuAI aspiration(settings);
+    AI::MinMaxV3::MoveEvaluation result = aspiration.suggest_move_evaluation(game);
+
+    EXPECT_EQ(AI::MinMaxV3::getBestMove(result, true), AI::MinMaxV3::getBestMove(expected, true));
+    EXPECT_EQ(result.score, expected.score);
+    EXPECT_EQ(aspiration.get_search_statistics().completed_depth, full_window.get_search_statistics().completed_depth);
+    EXPECT_GT(aspiration.get_search_statistics().aspiration_researches, 0);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
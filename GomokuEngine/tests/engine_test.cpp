@@ -1,6 +1,8 @@
 #include "engine/gomoku_engine.h"
 #include "utils/gomoku_utilities.h"
+#include "gomoku_test_helpers.h"
 #include "gtest/gtest.h"
+#include <random>
 
 void test_game_status(std::string move_str, bool expected_game_over, Player winner = Player::EMPTY)
 {
@@ -280,6 +282,60 @@ TEST(DoubleThreeTest, TestMakeDoubleThreeThrowError)
     ASSERT_THROW(game.make_move(4, 6), std::invalid_argument);
 }
 
+TEST(DoubleThreeTest, TestTryMakeDoubleThreeReturnsStatus)
+{
+    GomokuGame game(19, 19);
+
+    std::string move_str = "44,A4,45,A5,56,CA,66,CB";
+    apply_moves(game, move_str);
+
+    const std::string board_before = to_string(game);
+    MoveResult move_result;
+
+    EXPECT_EQ(game.try_make_move(4, 6, move_result), MoveStatus::DOUBLE_THREE);
+    EXPECT_EQ(to_string(game), board_before);
+    EXPECT_EQ(game.get_current_player(), X);
+
+    EXPECT_EQ(game.try_make_move(4, 4, move_result), MoveStatus::OCCUPIED_CELL);
+    EXPECT_EQ(game.try_make_move(-1, 4, move_result), MoveStatus::INVALID_COORDINATES);
+    EXPECT_EQ(game.try_make_move(4, 19, move_result), MoveStatus::INVALID_COORDINATES);
+
+    EXPECT_EQ(game.try_make_move(4, 7, move_result), MoveStatus::SUCCESS);
+    EXPECT_EQ(game.get_board_value(4, 7), X);
+    EXPECT_EQ(game.get_current_player(), O);
+}
+
+TEST(DoubleThreeTest, TestIsDoubleThreeDoesNotModifyGame)
+{
+    GomokuGame game(19, 19);
+
+    std::string move_str = "44,A4,45,A5,56,CA,66,CB";
+    apply_moves(game, move_str);
+
+    const std::string board_before = to_string(game);
+    const uint64_t hash_before = game.get_hash();
+
+    EXPECT_TRUE(game.is_double_three(4, 6, X));
+    EXPECT_FALSE(game.is_double_three(4, 7, X));
+    EXPECT_FALSE(game.is_double_three(4, 6, O));
+    EXPECT_FALSE(game.is_double_three(4, 4, X));
+    EXPECT_FALSE(game.is_double_three(-1, 4, X));
+
+    EXPECT_EQ(to_string(game), board_before);
+    EXPECT_EQ(game.get_hash(), hash_before);
+}
+
+TEST(DoubleThreeTest, TestIsDoubleThreeAllowsCapture)
+{
+    GomokuGame game(19, 19);
+
+    std::string move_str = "43,35,44,25,55,B7,15,B8,65,FC";
+    apply_moves(game, move_str);
+
+    EXPECT_FALSE(game.is_double_three(4, 5, X));
+    ASSERT_NO_THROW({ game.make_move(4, 5); });
+}
+
 TEST(DoubleThreeTest, TestMakingForkWithOpenFourAndOpenThreeShouldSucceed)
 {
     GomokuGame game(19, 19);
@@ -486,6 +542,69 @@ TEST(MoveResultTest, ReapplyMultipleMoves)
               "......\n");
 }
 
+TEST(MoveResultTest, CaptureInEveryDirection)
+{
+    GomokuGame game(9, 9);
+
+    for (int row_dir = -1; row_dir <= 1; ++row_dir)
+        for (int col_dir = -1; col_dir <= 1; ++col_dir)
+        {
+            if (row_dir == 0 && col_dir == 0)
+                continue;
+            game.set_board_value(4 + row_dir, 4 + col_dir, O);
+            game.set_board_value(4 + 2 * row_dir, 4 + 2 * col_dir, O);
+            game.set_board_value(4 + 3 * row_dir, 4 + 3 * col_dir, X);
+        }
+
+    MoveResult result = game.make_move(4, 4);
+
+    ASSERT_EQ(result.cell_changes.size(), CellChanges::capacity);
+    EXPECT_EQ(game.get_player_score(Player::BLACK), 16);
+
+    MoveResult copy = result;
+    game.reverse_move(copy);
+    EXPECT_EQ(game.get_board_value(4, 4), E);
+    EXPECT_EQ(game.get_board_value(3, 3), O);
+    EXPECT_EQ(game.get_player_score(Player::BLACK), 0);
+}
+
+TEST(MoveResultTest, JournaledReverseMatchesRecomputedReverse)
+{
+    GomokuGame game(19, 19);
+    apply_moves(game, "99,89,7A,88,8A,7B,6A,5A,A8,9A,87,B7");
+
+    GomokuGame recomputed = game;
+    game.set_pattern_journaling(true);
+
+    std::vector<MoveResult> moves;
+    for (const std::string &move : split("89,6B,98,78,67,A9,A7,69,AA,A8", ','))
+    {
+        MoveResult journaled_result;
+        MoveResult recomputed_result;
+        const int row = char_to_coordinate(move[0]);
+        const int col = char_to_coordinate(move[1]);
+        const MoveStatus status = game.try_make_move(row, col, journaled_result);
+        ASSERT_EQ(status, recomputed.try_make_move(row, col, recomputed_result));
+        if (status == MoveStatus::SUCCESS)
+            moves.push_back(journaled_result);
+    }
+
+    std::vector<MoveResult> recomputed_moves = moves;
+    for (size_t i = moves.size(); i-- > 0;)
+    {
+        game.reverse_move(moves[i]);
+        recomputed.reverse_move(recomputed_moves[i]);
+
+        for (Player player : {X, O})
+            ASSERT_NO_FATAL_FAILURE(assert_same_patterns(game.get_pattern_reconizer(player), recomputed.get_pattern_reconizer(player)));
+    }
+    EXPECT_EQ(game.get_pattern_reconizer(X).journaled_moves(), 0);
+
+    /** Moves made before journaling still reverse */
+    game.reverse_move(game.make_move(0, 0));
+    EXPECT_EQ(to_string(game), to_string(recomputed));
+}
+
 TEST(MoveResultTest, ReverseCapture)
 {
     GomokuGame game(7, 7);
@@ -632,6 +751,420 @@ TEST(PlayedBounds, PlayedBounds_ReverseMove)
     EXPECT_EQ(game.get_played_bounds().second, GomokuCellIndex(1, 1));
 }
 
+static void expect_relevant_cells_match_relevancy(const GomokuGame &game)
+{
+    int count = 0;
+    for (int row = 0; row < game.get_board_height(); ++row)
+        for (int col = 0; col < game.get_board_width(); ++col)
+        {
+            bool relevant = game.get_board_value(row, col) == E && game.get_cell_relevancy(row, col) > 0;
+            EXPECT_EQ(game.get_relevant_cells().contains(row, col), relevant) << row << ";" << col;
+            count += relevant;
+        }
+    EXPECT_EQ(game.get_relevant_cells().size(), count);
+}
+
+TEST(RelevantCells, FollowMovesAndCaptures)
+{
+    GomokuGame game(19, 19);
+
+    EXPECT_TRUE(game.get_relevant_cells().empty());
+
+    MoveResult first = game.make_move(0, 0);
+    EXPECT_EQ(game.get_relevant_cells().size(), 6);
+    expect_relevant_cells_match_relevancy(game);
+
+    std::vector<MoveResult> moves;
+    for (const std::string &move : split("22,11,33,44,55,23,99,32", ','))
+    {
+        moves.push_back(game.make_move(char_to_coordinate(move[0]), char_to_coordinate(move[1])));
+        expect_relevant_cells_match_relevancy(game);
+    }
+
+    /** 32 captured 23 and 22 */
+    EXPECT_EQ(game.get_board_value(2, 2), E);
+    EXPECT_TRUE(game.get_relevant_cells().contains(2, 2));
+
+    std::vector<std::pair<int, int>> visited;
+    game.get_relevant_cells().for_each([&visited](int row, int col)
+                                       { visited.emplace_back(row, col); });
+    EXPECT_TRUE(std::is_sorted(visited.begin(), visited.end()));
+    EXPECT_EQ(int(visited.size()), game.get_relevant_cells().size());
+
+    for (auto it = moves.rbegin(); it != moves.rend(); ++it)
+    {
+        game.reverse_move(*it);
+        expect_relevant_cells_match_relevancy(game);
+    }
+    game.reverse_move(first);
+    EXPECT_TRUE(game.get_relevant_cells().empty());
+}
+
+TEST(SpecialisationTest, StandardBoardMatchesAnySize)
+{
+    std::mt19937 rng(7);
+
+    /** Moves stay far enough from the edges for both boards to see the same patterns */
+    const int area = 13;
+    for (bool capture_enabled : {true, false})
+    {
+        for (int game_index = 0; game_index < 10; ++game_index)
+        {
+            GomokuGame standard(19, 19, capture_enabled);
+            GomokuGame any_size(24, 24, capture_enabled);
+            std::vector<MoveResult> moves;
+
+            while (!standard.is_game_over() && int(moves.size()) < 80)
+            {
+                const int row = rng() % area;
+                const int col = rng() % area;
+                MoveResult standard_move;
+                MoveResult any_size_move;
+                const MoveStatus status = standard.try_make_move(row, col, standard_move);
+                ASSERT_EQ(status, any_size.try_make_move(row, col, any_size_move));
+                if (status != MoveStatus::SUCCESS)
+                    continue;
+                moves.push_back(standard_move);
+
+                ASSERT_EQ(standard_move.cell_changes.size(), any_size_move.cell_changes.size());
+                for (int r = 0; r < area; ++r)
+                    for (int c = 0; c < area; ++c)
+                        ASSERT_EQ(standard.get_board_value(r, c), any_size.get_board_value(r, c));
+                ASSERT_EQ(standard.get_hash(), any_size.get_hash());
+                ASSERT_EQ(standard.is_game_over(), any_size.is_game_over());
+                ASSERT_EQ(standard.get_winner(), any_size.get_winner());
+                ASSERT_EQ(standard.get_relevant_cells().size(), any_size.get_relevant_cells().size());
+                for (Player player : {X, O})
+                {
+                    ASSERT_EQ(standard.get_player_score(player), any_size.get_player_score(player));
+                    ASSERT_EQ(standard.get_patterns_count(player), any_size.get_patterns_count(player));
+                }
+                if (!capture_enabled)
+                {
+                    ASSERT_EQ(standard_move.cell_changes.size(), 1);
+                }
+            }
+
+            for (auto it = moves.rbegin(); it != moves.rend(); ++it)
+                standard.reverse_move(*it);
+            EXPECT_EQ(standard.get_hash(), 0);
+            EXPECT_TRUE(standard.get_relevant_cells().empty());
+        }
+    }
+}
+
+TEST(MoveResultTest, JournalOverflowIsRecomputed)
+{
+    std::mt19937 rng(3);
+    GomokuGame game(19, 19);
+    game.make_move(9, 9);
+
+    GomokuGame recomputed = game;
+    game.set_pattern_journaling(true);
+
+    /** More moves than the journal holds */
+    std::vector<MoveResult> moves;
+    while (moves.size() < 60 && !game.is_game_over())
+    {
+        const auto [row, col] = random_relevant_cell(game, rng);
+        MoveResult journaled_result;
+        MoveResult recomputed_result;
+        const MoveStatus status = game.try_make_move(row, col, journaled_result);
+        ASSERT_EQ(status, recomputed.try_make_move(row, col, recomputed_result));
+        if (status == MoveStatus::SUCCESS)
+            moves.push_back(journaled_result);
+    }
+    ASSERT_EQ(moves.size(), 60);
+
+    for (size_t i = moves.size(); i-- > 0;)
+    {
+        game.reverse_move(moves[i]);
+        recomputed.reverse_move(moves[i]);
+
+        for (Player player : {X, O})
+            ASSERT_NO_FATAL_FAILURE(assert_same_patterns(game.get_pattern_reconizer(player), recomputed.get_pattern_reconizer(player)));
+    }
+    EXPECT_EQ(game.get_pattern_reconizer(X).journaled_moves(), 0);
+}
+
+TEST(MoveResultTest, PatternCountDeltaMatchesCounts)
+{
+    GomokuGame game(19, 19);
+
+    for (const std::string &move : split("99,89,7A,88,8A,7B,6A,5A,A8,9A,87,B7,89,6B,98,78,67,A9", ','))
+    {
+        const StructureCounts black_before = game.get_patterns_count(X);
+        const StructureCounts white_before = game.get_patterns_count(O);
+
+        MoveResult move_result;
+        if (game.try_make_move(char_to_coordinate(move[0]), char_to_coordinate(move[1]), move_result) != MoveStatus::SUCCESS)
+            continue;
+
+        for (int i = 0; i < StructureType::COUNT_STRUCTURE_TYPE; ++i)
+        {
+            EXPECT_EQ(move_result.pattern_count_delta.of(X)[i], game.get_patterns_count(X)[i] - black_before[i]);
+            EXPECT_EQ(move_result.pattern_count_delta.of(O)[i], game.get_patterns_count(O)[i] - white_before[i]);
+        }
+    }
+}
+
+TEST(BitboardTest, MatchesBoardDuringRandomGames)
+{
+    std::mt19937 rng(42);
+
+    for (int game_index = 0; game_index < 20; ++game_index)
+    {
+        GomokuGame game(19, 19);
+        game.make_move(9, 9);
+
+        while (!game.is_game_over() && !game.get_relevant_cells().empty())
+        {
+            const auto [row, col] = random_relevant_cell(game, rng);
+            MoveResult move_result;
+            game.try_make_move(row, col, move_result);
+
+            const GomokuBitboard &bitboard = game.get_bitboard();
+            for (int r = 0; r < 19; ++r)
+                for (int c = 0; c < 19; ++c)
+                    for (Player player : {X, O})
+                    {
+                        const bool is_player = game.get_board_value(r, c) == player;
+                        ASSERT_EQ(bool((bitboard.line(player, ROWS, r, c) >> c) & 1), is_player);
+                        ASSERT_EQ(bool((bitboard.line(player, COLS, r, c) >> r) & 1), is_player);
+                        ASSERT_EQ(bool((bitboard.line(player, DIAGONALS, r, c) >> c) & 1), is_player);
+                        ASSERT_EQ(bool((bitboard.line(player, ANTI_DIAGONALS, r, c) >> c) & 1), is_player);
+                    }
+
+            for (Player player : {X, O})
+                ASSERT_EQ(bitboard.has_five(player), game.get_pattern_reconizer(player).get_pattern_count()[StructureType::FIVE_OR_MORE] > 0);
+        }
+    }
+}
+
+TEST(MoveGainsTest, IncrementalGainsMatchRebuild)
+{
+    std::mt19937 rng(5);
+
+    auto expect_rebuilt_gains = [](const GomokuGame &game)
+    {
+        GomokuGame rebuilt(game);
+        rebuilt.set_move_gains_enabled(true);
+        const GomokuMoveGains &expected = rebuilt.get_move_gains();
+        const GomokuMoveGains &actual = game.get_move_gains();
+
+        for (int r = 0; r < game.get_board_height(); ++r)
+            for (int c = 0; c < game.get_board_width(); ++c)
+                for (Player player : {X, O})
+                {
+                    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
+                        ASSERT_EQ(actual.gains(player, r, c).directions[direction], expected.gains(player, r, c).directions[direction]) << r << ";" << c;
+                    ASSERT_EQ(actual.gains(player, r, c).threat, expected.gains(player, r, c).threat);
+                }
+    };
+
+    for (int game_index = 0; game_index < 10; ++game_index)
+    {
+        GomokuGame game(17, 19);
+        game.set_move_gains_enabled(true);
+        game.make_move(9, 8);
+
+        std::vector<MoveResult> moves;
+        while (!game.is_game_over() && moves.size() < 80)
+        {
+            const auto [row, col] = random_relevant_cell(game, rng);
+            MoveResult move_result;
+            if (game.try_make_move(row, col, move_result) == MoveStatus::SUCCESS)
+                moves.push_back(move_result);
+
+            expect_rebuilt_gains(game);
+        }
+
+        while (!moves.empty())
+        {
+            game.reverse_move(moves.back());
+            moves.pop_back();
+            expect_rebuilt_gains(game);
+        }
+    }
+}
+
+TEST(MoveGainsTest, FindsFoursOnTheirLine)
+{
+    GomokuGame game(19, 19);
+    game.set_move_gains_enabled(true);
+    apply_moves(game, "99,00,9A,01,9B,03");
+
+    const GomokuMoveGains &gains = game.get_move_gains();
+    EXPECT_EQ(gains.gains(X, 9, 8).directions[PatternDirection::LeftToRight], StructureType::OPEN_FOUR);
+    EXPECT_EQ(gains.gains(X, 9, 12).directions[PatternDirection::LeftToRight], StructureType::OPEN_FOUR);
+    EXPECT_EQ(gains.gains(X, 9, 8).directions[PatternDirection::UpToDown], StructureType::OPEN_ONE);
+    EXPECT_EQ(gains.gains(O, 0, 2).directions[PatternDirection::LeftToRight], StructureType::FOUR);
+    EXPECT_GE(gains.gains(X, 9, 8).threat, GomokuMoveGains::threat_weight(StructureType::OPEN_FOUR));
+    EXPECT_LT(gains.gains(O, 5, 5).threat, GomokuMoveGains::threat_weight(StructureType::OPEN_THREE));
+    EXPECT_EQ(gains.gains(X, 9, 9).threat, 0);
+}
+
+TEST(BitboardTest, CapturesAtTheBoardEdges)
+{
+    GomokuGame game(19, 19);
+    apply_moves(game, "01,02,99,03,98");
+
+    const GomokuBitboard &bitboard = game.get_bitboard();
+    EXPECT_TRUE(bitboard.captures(0, 4, 0, -1, X));
+    EXPECT_FALSE(bitboard.captures(0, 4, 0, -1, O));
+    EXPECT_FALSE(bitboard.captures(0, 4, 0, 1, X));
+    EXPECT_FALSE(bitboard.captures(0, 0, 0, -1, X));
+    EXPECT_FALSE(bitboard.captures(18, 18, 1, 1, X));
+    EXPECT_FALSE(bitboard.captures(0, 18, -1, 1, X));
+}
+
+TEST(BitboardTest, CapturableStonesMatchBoard)
+{
+    std::mt19937 rng(7);
+
+    for (int game_index = 0; game_index < 20; ++game_index)
+    {
+        GomokuGame game(19, 19);
+        game.make_move(9, 9);
+
+        std::vector<MoveResult> moves;
+        while (!game.is_game_over() && !game.get_relevant_cells().empty())
+        {
+            const auto [row, col] = random_relevant_cell(game, rng);
+            MoveResult move_result;
+            if (game.try_make_move(row, col, move_result) == MoveStatus::SUCCESS)
+                moves.push_back(move_result);
+        }
+
+        /** Check the positions again while undoing the game, so captured stones come back too */
+        for (size_t i = moves.size(); i-- > 0;)
+        {
+            game.reverse_move(moves[i]);
+
+            const GomokuBitboard &bitboard = game.get_bitboard();
+            for (Player player : {X, O})
+            {
+                bool any_capturable = false;
+                for (int r = 0; r < 19; ++r)
+                    for (int c = 0; c < 19; ++c)
+                    {
+                        bool capturable = false;
+                        for (auto [row_dir, col_dir] : {std::pair{0, 1}, {1, 0}, {1, 1}, {1, -1}, {0, -1}, {-1, 0}, {-1, -1}, {-1, 1}})
+                        {
+                            /** The stone starts a pair in this direction, flanked by an opponent stone and an empty cell */
+                            const int before_row = r - row_dir, before_col = c - col_dir;
+                            const int after_row = r + 2 * row_dir, after_col = c + 2 * col_dir;
+                            if (game.get_board_value(r, c) != player || !game.coordinates_are_valid(before_row, before_col) || !game.coordinates_are_valid(after_row, after_col) || game.get_board_value(r + row_dir, c + col_dir) != player)
+                                continue;
+                            const Player before = game.get_board_value(before_row, before_col);
+                            const Player after = game.get_board_value(after_row, after_col);
+                            capturable = capturable || (before == game.other_player(player) && after == E) || (before == E && after == game.other_player(player));
+                        }
+                        ASSERT_EQ(bitboard.is_capturable(player, r, c), capturable);
+                        any_capturable = any_capturable || capturable;
+                    }
+                ASSERT_EQ(bitboard.has_capturable_stones(player), any_capturable);
+
+                GomokuBitboard probe = bitboard;
+                ASSERT_EQ(probe.find_uncapturable_five(player), bitboard.has_uncapturable_five(player));
+            }
+        }
+    }
+}
+
+TEST(BitboardTest, UncapturableFive)
+{
+    /** The five of black has a capturable two crossing its second stone */
+    GomokuGame game(19, 19);
+    apply_moves(game, "99,8A,9A,00,9B,02,9C,04,AA,06,9D");
+    EXPECT_FALSE(game.get_bitboard().has_uncapturable_five(X));
+    EXPECT_FALSE(game.is_game_over());
+
+    GomokuGame safe_game(19, 19);
+    apply_moves(safe_game, "99,89,9A,8A,9B,8B,9C,8C,9D");
+    EXPECT_TRUE(safe_game.get_bitboard().has_uncapturable_five(X));
+    EXPECT_TRUE(safe_game.is_game_over());
+}
+
+TEST(BitboardTest, FiveMadeUncapturableAwayFromIt)
+{
+    /** Black protects its five by extending the capturable two, the move isn't on the five line */
+    GomokuGame game(19, 19);
+    apply_moves(game, "99,8A,9A,00,9B,02,9C,04,AA,06,9D,08");
+    EXPECT_FALSE(game.is_game_over());
+
+    MoveResult move_result = game.make_move(11, 10);
+    EXPECT_TRUE(game.is_game_over());
+    EXPECT_EQ(game.get_winner(), X);
+
+    /** The five is still found when the winning move is played again */
+    game.reverse_move(move_result);
+    EXPECT_FALSE(game.is_game_over());
+    game.make_move(11, 10);
+    EXPECT_TRUE(game.is_game_over());
+}
+
+TEST(HashTest, ReverseMoveRestoresHash)
+{
+    GomokuGame game(7, 7);
+
+    EXPECT_EQ(game.get_hash(), 0);
+
+    std::string move_str = "11,22,21,33,44,01,34";
+    apply_moves(game, move_str);
+
+    const uint64_t hash_before = game.get_hash();
+    MoveResult result = game.make_move(3, 1);
+
+    EXPECT_EQ(game.get_player_score(Player::WHITE), 2);
+    EXPECT_NE(game.get_hash(), hash_before);
+
+    const uint64_t hash_after = game.get_hash();
+    game.reverse_move(result);
+    EXPECT_EQ(game.get_hash(), hash_before);
+
+    game.reapply_move(result);
+    EXPECT_EQ(game.get_hash(), hash_after);
+}
+
+TEST(HashTest, TranspositionsShareHash)
+{
+    GomokuGame game1(19, 19);
+    GomokuGame game2(19, 19);
+
+    apply_moves(game1, "99,9A,AA,A9");
+    apply_moves(game2, "AA,A9,99,9A");
+
+    EXPECT_EQ(game1.get_hash(), game2.get_hash());
+
+    game1.make_move(5, 5);
+    EXPECT_NE(game1.get_hash(), game2.get_hash());
+}
+
+TEST(HashTest, SideToMoveChangesHash)
+{
+    GomokuGame game1(19, 19);
+    GomokuGame game2(19, 19);
+
+    apply_moves(game1, "99,9A,AA");
+    apply_moves(game2, "99,9A");
+    game2.set_board_value(10, 10, Player::BLACK);
+
+    EXPECT_NE(game1.get_hash(), game2.get_hash());
+}
+
+TEST(HashTest, RejectedMoveKeepsHash)
+{
+    GomokuGame game(19, 19);
+
+    std::string move_str = "44,A4,45,A5,56,CA,66,CB";
+    apply_moves(game, move_str);
+
+    const uint64_t hash_before = game.get_hash();
+    ASSERT_THROW(game.make_move(4, 6), std::invalid_argument);
+    EXPECT_EQ(game.get_hash(), hash_before);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
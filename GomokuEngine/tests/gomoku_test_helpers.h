@@ -0,0 +1,35 @@
+#pragma once
+
+#include "engine/gomoku_engine.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <utility>
+#include <vector>
+
+/** Helpers shared by the tests playing random games */
+
+/** Relevant cell of the game drawn with rng, the game must have one */
+inline std::pair<int, int> random_relevant_cell(const GomokuGame &game, std::mt19937 &rng)
+{
+    std::vector<std::pair<int, int>> candidates;
+    game.get_relevant_cells().for_each([&candidates](int row, int col)
+                                       { candidates.emplace_back(row, col); });
+    return candidates[rng() % candidates.size()];
+}
+
+/** Pattern counts and every cell of the pattern matrices, border included, are the same.
+ * Use with ASSERT_NO_FATAL_FAILURE to stop the calling test at the first difference. */
+inline void assert_same_patterns(const GomokuPatternReconizer &actual, const GomokuPatternReconizer &expected)
+{
+    ASSERT_EQ(actual.get_pattern_count(), expected.get_pattern_count());
+    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
+    {
+        const PatternCellMatrix &actual_matrix = actual.get_pattern_cell_matrix(PatternDirection(direction));
+        const PatternCellMatrix &expected_matrix = expected.get_pattern_cell_matrix(PatternDirection(direction));
+        for (int r = -1; r <= expected_matrix.get_height(); ++r)
+        {
+            for (int c = -1; c <= expected_matrix.get_width(); ++c)
+                ASSERT_EQ(actual_matrix(r, c).data(), expected_matrix(r, c).data()) << PatternDirection(direction) << " " << r << ";" << c;
+        }
+    }
+}
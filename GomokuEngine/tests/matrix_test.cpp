@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 #include "matrix/Matrix.hpp"
+#include "matrix/PaddedMatrix.hpp"
+#include <type_traits>
 
 TEST(MatrixTest, Size)
 {
@@ -23,6 +25,53 @@ TEST(MatrixTest, Values)
     }
 }
 
+TEST(PaddedMatrixTest, CapacityAndCopy)
+{
+    EXPECT_THROW((PaddedMatrix<int, 4, 4, 1>(5, 4)), std::invalid_argument);
+
+    PaddedMatrix<int, 8, 8, 1> m(5, 3);
+    EXPECT_EQ(m.get_width(), 5);
+    EXPECT_EQ(m.get_height(), 3);
+    EXPECT_TRUE(m.is_in_bound(2, 4));
+    EXPECT_FALSE(m.is_in_bound(3, 0));
+    EXPECT_TRUE(m.is_in_padded_bound(3, -1));
+    EXPECT_FALSE(m.is_in_padded_bound(4, 0));
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 5; j++)
+            m(i, j) = i * 5 + j;
+
+    PaddedMatrix<int, 8, 8, 1> copy = m;
+    m(1, 1) = -1;
+    EXPECT_EQ(copy(1, 1), 6);
+    EXPECT_EQ((copy[PaddedMatrix<int, 8, 8, 1>::Index(2, 4)]), 14);
+    EXPECT_TRUE((std::is_trivially_copyable<PaddedMatrix<int, 8, 8, 1>>::value));
+}
+
+TEST(PaddedMatrixTest, BorderAndOffsets)
+{
+    typedef PaddedMatrix<int8_t, 19, 19, 2> Bytes;
+    typedef PaddedMatrix<uint16_t, 25, 25, 1> Words;
+    EXPECT_EQ(Bytes::stride, 64);
+    EXPECT_EQ(Words::stride, 32);
+    EXPECT_EQ(Words::stride * sizeof(uint16_t) % 64, 0);
+
+    Bytes m(5, 4, -1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&m.at(0)) % 64, 0);
+    for (int row = -2; row < 6; row++)
+        for (int col = -2; col < 7; col++)
+            EXPECT_EQ(m(row, col), m.is_in_bound(row, col) ? 0 : -1) << row << ";" << col;
+
+    m(2, 3) = 7;
+    EXPECT_EQ(m.at(Bytes::offset_of(2, 3)), 7);
+    EXPECT_EQ(m.at(Bytes::offset_of(1, 2) + Bytes::offset_of_direction(1, 1)), 7);
+    EXPECT_EQ(m.at(Bytes::offset_of(0, 0) + Bytes::offset_of_direction(-2, -2)), -1);
+
+    m.fill_border(-3);
+    EXPECT_EQ(m(-1, 5), -3);
+    EXPECT_EQ(m(2, 3), 7);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 #include "engine/gomoku_engine.h"
+#include "engine/gomoku_window_reconizer.h"
 #include "utils/gomoku_utilities.h"
+#include "gomoku_test_helpers.h"
+#include <random>
 
 static const std::vector<std::pair<std::vector<Player>, StructureType>> structures_list = {
     {{E, O, X}, StructureType::ONE},
@@ -104,6 +107,131 @@ TEST(Structures, WalledStructs)
     }
 }
 
+TEST(Structures, IncrementalUpdatesMatchFullScan)
+{
+    std::mt19937 rng(7);
+
+    for (int game_index = 0; game_index < 10; ++game_index)
+    {
+        GomokuGame game(15, 12);
+        game.make_move(6, 7);
+
+        for (int move = 0; move < 60 && !game.is_game_over(); ++move)
+        {
+            const auto [row, col] = random_relevant_cell(game, rng);
+            MoveResult move_result;
+            game.try_make_move(row, col, move_result);
+
+            for (Player player : {X, O})
+            {
+                GomokuPatternReconizer reconizer(player);
+                reconizer.find_patterns_in_board(game);
+
+                ASSERT_NO_FATAL_FAILURE(assert_same_patterns(game.get_pattern_reconizer(player), reconizer));
+            }
+        }
+    }
+}
+
+TEST(Structures, PatternLinesAreContiguous)
+{
+    const int steps[PatternDirection::Count_PatternDirection][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+
+    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
+    {
+        PatternCellMatrix matrix(PatternDirection(direction), 19, 17);
+        std::vector<bool> used(PatternCellMatrix::padded_size * PatternCellMatrix::padded_size, false);
+
+        for (int row = -1; row <= matrix.get_height(); ++row)
+            for (int col = -1; col <= matrix.get_width(); ++col)
+            {
+                const int offset = matrix.offset_of(row, col);
+                ASSERT_FALSE(used[offset]);
+                used[offset] = true;
+
+                const int next_row = row + steps[direction][0];
+                const int next_col = col + steps[direction][1];
+                if (matrix.is_in_padded_bound(next_row, next_col))
+                {
+                    ASSERT_EQ(matrix.offset_of(next_row, next_col), offset + 1) << PatternDirection(direction) << " " << row << ";" << col;
+                }
+
+                matrix(row, col) = PatternCellData::pre_bound_element();
+                ASSERT_EQ(&matrix.at(offset), &matrix(row, col));
+            }
+    }
+}
+
+TEST(Structures, WindowStructureAt)
+{
+    GomokuWindowReconizer reconizer(O);
+
+    for (const auto &[structure, expected_type] : structures_list)
+    {
+        for (std::vector<Player> flanked_structure : generate_flanked_structures(structure, expected_type))
+        {
+            GomokuGame game(flanked_structure.size(), 1);
+
+            for (size_t i = 0; i < flanked_structure.size(); i++)
+            {
+                if (flanked_structure[i] != E)
+                    game.set_board_value(0, i, flanked_structure[i]);
+            }
+
+            /** Every stone of the structure is part of it */
+            for (size_t i = 1; i < flanked_structure.size() - 1; i++)
+            {
+                if (flanked_structure[i] == O)
+                {
+                    EXPECT_EQ(reconizer.structure_at(game.get_bitboard(), 0, i, PatternDirection::LeftToRight), expected_type) << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(Structures, WindowGainMatchesPlayedStone)
+{
+    std::mt19937 rng(11);
+
+    for (int game_index = 0; game_index < 10; ++game_index)
+    {
+        GomokuGame game(15, 12);
+
+        for (int stone = 0; stone < 70; ++stone)
+        {
+            const int row = rng() % 12;
+            const int col = rng() % 15;
+            const Player player = Player(1 + rng() % 2);
+            if (game.get_board_value(row, col) == E)
+                game.set_board_value(row, col, player);
+        }
+
+        for (Player player : {X, O})
+        {
+            GomokuWindowReconizer reconizer(player);
+
+            for (int row = 0; row < 12; ++row)
+            {
+                for (int col = 0; col < 15; ++col)
+                {
+                    if (game.get_board_value(row, col) != E)
+                        continue;
+
+                    GomokuGame played(game);
+                    played.set_board_value(row, col, player);
+                    for (int direction = 0; direction < PatternDirection::Count_PatternDirection; ++direction)
+                    {
+                        ASSERT_EQ(reconizer.gain_at(game.get_bitboard(), row, col, PatternDirection(direction)),
+                                  reconizer.structure_at(played.get_bitboard(), row, col, PatternDirection(direction)))
+                            << PatternDirection(direction) << " " << row << ";" << col;
+                    }
+                }
+            }
+        }
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);